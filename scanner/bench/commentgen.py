@@ -0,0 +1,19 @@
+#!/usr/bin/env python3
+"""Generate a comment and white-space heavy C- program: commentgen.py NDECLS [seed]"""
+import sys, random
+n = int(sys.argv[1])
+R = random.Random(int(sys.argv[2]) if len(sys.argv) > 2 else 1)
+words = ['lorem', 'ipsum', 'dolor', 'sit', 'amet', 'consectetur', 'adipiscing', 'elit']
+def name(i):
+    s = ''
+    while True:
+        s += chr(97 + i % 26); i //= 26
+        if i == 0: return 'verylongidentifiernumber' + s
+out = []
+w = out.append
+for i in range(n):
+    w('/* %s\n   %s\n */\n' % (' '.join(R.choice(words) for _ in range(40)), 'x ' * 20))
+    w('int %s;\n' % name(i))
+    w('        \t        \n' * 3)
+w('void main(void) { }\n')
+sys.stdout.write(''.join(out))
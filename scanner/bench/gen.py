@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Generate a valid C- program: gen.py NFUNCS STMTS_PER_FUNC [seed] [--oneline]"""
+import sys, random
+nf = int(sys.argv[1]); ns = int(sys.argv[2])
+seed = int(sys.argv[3]) if len(sys.argv) > 3 and not sys.argv[3].startswith('-') else 1
+oneline = '--oneline' in sys.argv
+R = random.Random(seed)
+out = []
+w = out.append
+w('/* generated corpus */\n')
+w('int gtable[100];\nint gcount;\n')
+def expr(vars, d=0):
+    r = R.random()
+    if d > 3 or r < 0.3:
+        c = R.random()
+        if c < 0.4: return str(R.randint(0, 999))
+        if c < 0.8: return R.choice(vars)
+        return 'gtable[%s]' % R.choice(vars)
+    op = R.choice(['+', '-', '*', '/', '+', '-'])
+    e = '%s %s %s' % (expr(vars, d+1), op, expr(vars, d+1))
+    return '(%s)' % e if R.random() < 0.3 else e
+def cond(vars):
+    return '%s %s %s' % (expr(vars, 2), R.choice(['<', '<=', '>', '>=', '==', '!=']), expr(vars, 2))
+funcs = []
+for f in range(nf):
+    name = 'function' + ''.join(chr(97 + int(c)) for c in str(f))
+    np = R.randint(1, 4)
+    params = ['param%s' % chr(97+i) for i in range(np)]
+    w('/* function %d: computes something\n   over several lines */\n' % f)
+    w('int %s(%s)\n{\n' % (name, ', '.join('int ' + p for p in params)))
+    locs = ['localvar%s' % chr(97+i) for i in range(3)]
+    for l in locs: w('    int %s;\n' % l)
+    vars = params + locs
+    for l in locs: w('    %s = %s;\n' % (l, expr(params)))
+    for s in range(ns):
+        r = R.random()
+        if r < 0.5:
+            w('    %s = %s;\n' % (R.choice(locs), expr(vars)))
+        elif r < 0.65:
+            w('    if (%s) %s = %s; else { %s = %s; }\n' % (cond(vars), R.choice(locs), expr(vars), R.choice(locs), expr(vars)))
+        elif r < 0.75:
+            w('    while (%s) { %s = %s - 1; }\n' % (cond(vars), R.choice(locs), R.choice(locs)))
+        elif r < 0.85 and funcs:
+            g, gp = R.choice(funcs)
+            w('    %s = %s(%s);\n' % (R.choice(locs), g, ', '.join(expr(vars, 2) for _ in range(gp))))
+        elif r < 0.92:
+            w('    gtable[%s] = %s; /* store */\n' % (R.choice(vars), expr(vars)))
+        else:
+            w('    output(%s);\n' % expr(vars))
+    w('    return %s;\n}\n\n' % expr(vars))
+    funcs.append((name, np))
+w('void main(void)\n{\n    int i;\n    i = input();\n')
+for g, gp in funcs[-5:]:
+    w('    output(%s(%s));\n' % (g, ', '.join('i' for _ in range(gp))))
+w('}\n')
+s = ''.join(out)
+if oneline:
+    # keep it lexically valid: comments and tokens never need newlines
+    s = s.replace('\n', ' ')
+sys.stdout.write(s)
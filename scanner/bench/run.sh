@@ -0,0 +1,18 @@
+#!/bin/sh
+# run.sh [N]: builds the scanner benchmarks, generates a corpus and
+# prints the best of N runs (default 11) of each scanner on it.
+# Run from scanner/ after a make clean, so that every object is built
+# with CFLAGS (default -O2). The corpus has 8.56M tokens in 32 MB.
+n=${1:-11}
+corpus=${TMPDIR:-/tmp}/scanbench.cm
+make CFLAGS="${CFLAGS:--O2}" scanbench scanbench_flex >/dev/null || exit 1
+[ -f $corpus ] || python3 bench/gen.py 7000 40 > $corpus
+best()
+{ i=0
+  while [ $i -lt $n ]; do
+    ./$1 $corpus
+    i=$((i+1))
+  done | sort -t, -k3 -n | head -1
+}
+echo "table DFA  $(best scanbench)"
+echo "flex       $(best scanbench_flex)"
@@ -0,0 +1,64 @@
+/****************************************************/
+/* File: scanbench.c                                */
+/* Scanner benchmark: runs getToken over a source   */
+/* and reports tokens per second; linked with       */
+/* scan.o for the DFA scanner or with lex.yy.o for  */
+/* the flex one                                     */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../scan.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define cycles() __rdtsc()
+#else
+#define cycles() 0ULL
+#endif
+
+FILE * source;
+FILE * listing;
+FILE * code;
+int lineno = 0;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+int Error = FALSE;
+
+static double now(void)
+{ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec/1e9;
+}
+
+int main(int argc, char * argv[])
+{ long n = 0, bytes;
+  double t;
+  unsigned long long c;
+  if (argc != 2)
+  { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
+    exit(1);
+  }
+  source = fopen(argv[1],"r");
+  if (source == NULL)
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  fseek(source,0,SEEK_END);
+  bytes = ftell(source);
+  rewind(source);
+  listing = stdout;
+  t = now();
+  c = cycles();
+  while (getToken() != ENDFILE) n++;
+  c = cycles() - c;
+  t = now() - t;
+  printf("%ld tokens, %d lines, %.3f s, %.1fM tokens/s",
+         n,lineno,t,n/t/1e6);
+  if (c != 0) printf(", %.3f bytes/cycle",(double) bytes/c);
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,24 @@
+#!/bin/sh
+# simd.sh [N]: prints the best of N runs (default 9) of the DFA
+# scanner with its span helpers built scalar, with SSE2 and with AVX2,
+# on a comment and white-space heavy corpus of 8 MB and on the dense
+# corpus of run.sh. Run from scanner/ after a make clean, so that
+# every object is built with CFLAGS (default -O2).
+n=${1:-9}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" scanbench scanbench_scalar scanbench_avx2 >/dev/null || exit 1
+[ -f $dir/scancomments.cm ] || python3 bench/commentgen.py 20000 > $dir/scancomments.cm
+[ -f $dir/scanbench.cm ] || python3 bench/gen.py 7000 40 > $dir/scanbench.cm
+best()
+{ i=0
+  while [ $i -lt $n ]; do
+    ./$1 $2
+    i=$((i+1))
+  done | sort -t, -k3 -n | head -1
+}
+for f in scancomments scanbench; do
+  echo "$f.cm:"
+  echo "  scalar  $(best scanbench_scalar $dir/$f.cm)"
+  echo "  SSE2    $(best scanbench $dir/$f.cm)"
+  echo "  AVX2    $(best scanbench_avx2 $dir/$f.cm)"
+done
@@ -8,48 +8,115 @@
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "simdscan.h"
+
+/* character classes, states and transition
+   tables of the scanner DFA, generated by scangen */
+#include "scantab.h"
+
+/* lexeme of identifier or reserved word,
+   grown by doubling as long tokens need it */
+char * tokenString = NULL;
+static int tokenStringSize = 0;
+
+/* BUFLEN = size of each block read from the
+   source; lines may be any length and span
+   several blocks */
+#define BUFLEN 65536
+
+/* inBuf[1..bufsize) holds the current block;
+   inBuf[0] keeps the last char of the previous
+   block so ungetNextChar works across a refill */
+static char inBuf[BUFLEN+1];
+static int linepos = 0; /* current position in inBuf */
+static int bufsize = 0; /* end of valid chars in inBuf */
+static int atLineStart = TRUE; /* next char begins a line */
+static int echoing = FALSE; /* rest of line still to echo */
+static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
 
-/* states in scanner DFA */
-typedef enum
-   { START,INEQ,INCOMMENT,INNUM,INID,DONE,INLT,INGT,INNE,INOVER,INCOMMENT_ }
-   StateType;
-
-/* lexeme of identifier or reserved word */
-char tokenString[MAXTOKENLEN+1];
-
-/* BUFLEN = length of the input buffer for
-   source code lines */
-#define BUFLEN 256
+/* fillBuf moves the unread chars to the front of
+   inBuf and reads as much of the source as fits
+   after them; returns FALSE at end of file */
+static int fillBuf(void)
+{ int keep = bufsize - linepos;
+  size_t n;
+  if (linepos > 0) memmove(inBuf,inBuf+linepos-1,keep+1);
+  n = fread(inBuf+1+keep,1,BUFLEN-keep,source);
+  bufsize = 1 + keep + (int) n;
+  linepos = 1;
+  return n > 0;
+}
 
-static char lineBuf[BUFLEN]; /* holds the current line */
-static int linepos = 0; /* current position in LineBuf */
-static int bufsize = 0; /* current size of buffer string */
-static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
+/* echoLine echoes the current line from linepos
+   up to its newline, first reading the rest of the
+   line into inBuf when it fits; longer lines are
+   echoed one block at a time */
+static void echoLine(void)
+{ char * nl;
+  while ((nl = memchr(inBuf+linepos,'\n',bufsize-linepos)) == NULL
+         && bufsize-linepos < BUFLEN && fillBuf())
+    ;
+  int end = nl ? (int) (nl-inBuf) + 1 : bufsize;
+  fwrite(inBuf+linepos,1,end-linepos,listing);
+  echoing = (nl == NULL);
+}
 
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
+/* getNextChar fetches the next character from
+   inBuf, reading in a new block if inBuf is
    exhausted */
 static int getNextChar(void)
-{ if (!(linepos < bufsize))
-  { lineno++;
-    if (fgets(lineBuf,BUFLEN-1,source))
-    { if (EchoSource) fprintf(listing,"%4d: %s",lineno,lineBuf);
-      bufsize = strlen(lineBuf);
-      linepos = 0;
-      return lineBuf[linepos++];
-    }
-    else
-    { EOF_flag = TRUE;
+{ int c;
+  if (atLineStart || !(linepos < bufsize))
+  { if (!(linepos < bufsize) && !fillBuf())
+    { lineno++;
+      EOF_flag = TRUE;
       return EOF;
     }
+    if (atLineStart)
+    { lineno++;
+      atLineStart = FALSE;
+      if (EchoSource)
+      { fprintf(listing,"%4d: ",lineno);
+        echoing = TRUE;
+      }
+    }
+    if (echoing) echoLine();
   }
-  else return lineBuf[linepos++];
+  c = (unsigned char) inBuf[linepos++];
+  atLineStart = (c == '\n');
+  return c;
 }
 
 /* ungetNextChar backtracks one character
-   in lineBuf */
+   in inBuf */
 static void ungetNextChar(void)
-{ if (!EOF_flag) linepos-- ;}
+{ if (!EOF_flag)
+  { linepos--;
+    if (inBuf[linepos] == '\n') atLineStart = FALSE;
+  }
+}
+
+/* skipLines consumes inBuf[from..to) without the
+   DFA, counting the newlines in it the way
+   getNextChar would; returns the new position */
+static int skipLines(int from, int to, int * lineStart)
+{ if (to > from)
+  { int last = (inBuf[to-1] == '\n');
+    lineno += *lineStart + countNewlines(inBuf+from,inBuf+to) - last;
+    *lineStart = last;
+  }
+  return to;
+}
+
+/* growTokenString doubles the space for tokenString */
+static void growTokenString(void)
+{ tokenStringSize = tokenStringSize ? 2*tokenStringSize : 64;
+  tokenString = (char *) realloc(tokenString,tokenStringSize);
+  if (tokenString == NULL)
+  { fprintf(listing,"Out of memory error at line %d\n",lineno);
+    exit(1);
+  }
+}
 
 /* lookup table of reserved words */
 static struct
@@ -82,222 +149,100 @@ TokenType getToken(void)
    int tokenStringIndex = 0;
    /* holds current token to be returned */
    TokenType currentToken;
-   /* current state - always begins at START */
-   StateType state = START;
-   /* flag to indicate save to tokenString */
-   int save;
-   while (state != DONE)
-   { int c = getNextChar();
-     save = TRUE;
-     switch (state)
-     { case START:
-         if (isdigit(c))
-           state = INNUM;
-         else if (isalpha(c))
-           state = INID;
-         /*
-         else if (c == ':')
-           state = INASSIGN;
-         */
-         else if ((c == ' ') || (c == '\t') || (c == '\n'))
-           save = FALSE;
-         
-         else if (c == '/')
-         {
-           state = INOVER;
-         }
-
-         else if (c == '=')
-         {
-          state = INEQ;
-         }
-
-         else if (c == '<')
-         {
-          state = INLT;
-         }
-
-         else if (c == '>')
-         {
-          state = INGT;
-         }
-
-         else if (c == '!')
-         {
-          state = INNE;
-         }
-
-         else
-         { state = DONE;
-           switch (c)
-           { case EOF:
-               save = FALSE;
-               currentToken = ENDFILE;
-               break;
-             /*
-             case '=':
-               currentToken = EQ;
-               break;
-             */
-             case '<':
-               currentToken = LT;
-               break;
-             case '+':
-               currentToken = PLUS;
-               break;
-             case '-':
-               currentToken = MINUS;
-               break;
-             case '*':
-               currentToken = TIMES;
-               break;
-             case '(':
-               currentToken = LPAREN;
-               break;
-             case ')':
-               currentToken = RPAREN;
-               break;
-             case '{':
-               currentToken = LCURLY;
-               break;
-             case '}':
-               currentToken = RCURLY;
-               break;
-             case '[':
-               currentToken = LBRACE;
-               break;
-             case ']':
-               currentToken = RBRACE;
-               break;
-             case ';':
-               currentToken = SEMI;
-               break;
-             case ',':
-               currentToken = COMMA;
-               break;
-             default:
-               currentToken = ERROR;
-               break;
-           }
-         }
-         break;
-
-       case INOVER:
-         if( c == '*' ) state = INCOMMENT;
-
-         else
-         {
-          ungetNextChar();
-          save = FALSE;
-          currentToken = OVER;
-          state = DONE;
-         }
-         break;
-       
-       case INCOMMENT:
-         save = FALSE;
-         if (c == EOF)
-         { state = DONE;
-           currentToken = ENDFILE;
-         }
-         else if ( c == '*' ) state = INCOMMENT_;
-         break;
-
-       case INCOMMENT_:
-         save = FALSE;
-         if (c == EOF)
-         { state = DONE;
-           currentToken = ENDFILE;
-         }
-         else if (c == '/') state = START;
-         else state = INCOMMENT;
-         break;
-
-       case INEQ:
-         if( c == '=' ) currentToken = EQ;
-         else{
-          ungetNextChar();
-          save = FALSE;
-          currentToken = ASSIGN;
-         }
-         state = DONE;
-         break;
-
-       case INLT:
-         if (c == '=') currentToken = LE;
-         else{
-          ungetNextChar();
-          save = FALSE;
-          currentToken = LT;
-        }
-         state = DONE;
-         break;
-
-       case INGT:
-         if (c == '=') currentToken = GE;
-         else{
-          ungetNextChar();
-          save = FALSE;
-          currentToken = GT;
-        }
-         state = DONE;
-         break;
-
-       case INNE:
-         if (c == '=') currentToken = NE;
-         else{
-          ungetNextChar();
-          save = FALSE;
-          currentToken = ERROR;
-        }
-         state = DONE;
-         break;
-         /*
-       case INASSIGN:
-         state = DONE;
-         if (c == '=')
-           currentToken = ASSIGN;
-         else
-         { 
-           ungetNextChar();
-           save = FALSE;
-           currentToken = ERROR;
-         }
-         break;
-         */
-       case INNUM:
-         if (!isdigit(c))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = NUM;
-         }
-         break;
-       case INID:
-         if (!isalpha(c))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = ID;
-         }
-         break;
-       case DONE:
-       default: /* should never happen */
-         fprintf(listing,"Scanner Bug: state= %d\n",state);
-         state = DONE;
-         currentToken = ERROR;
-         break;
+   /* current state - always begins at ST_START */
+   int state = ST_START;
+   /* transition taken on the current character */
+   int next;
+   int c, cl;
+   /* local copies of the input position so the
+      common case needs no call of getNextChar */
+   int pos = linepos;
+   int lineStart = atLineStart;
+   if (tokenString == NULL) growTokenString();
+   /* run the DFA until it reaches a final state;
+      the token is then known from the last
+      transition alone */
+   for (;;)
+   { if (pos < bufsize && !lineStart)
+     { c = (unsigned char) inBuf[pos++];
+       lineStart = (c == '\n');
      }
-     if ((save) && (tokenStringIndex <= MAXTOKENLEN))
+     else
+     { linepos = pos;
+       atLineStart = lineStart;
+       c = getNextChar();
+       pos = linepos;
+       lineStart = atLineStart;
+     }
+     cl = charClass[c+1];
+     next = transition[state][cl];
+     if (next & SAVE)
+     { if (tokenStringIndex+1 >= tokenStringSize)
+         growTokenString();
        tokenString[tokenStringIndex++] = (char) c;
-     if (state == DONE)
-     { tokenString[tokenStringIndex] = '\0';
-       if (currentToken == ID)
-         currentToken = reservedLookup(tokenString);
+     }
+     else if (next & RESET)
+       tokenStringIndex = 0;
+     if ((next & STATEMASK) >= ST_ACCEPT) break;
+     state = next & STATEMASK;
+     if (next & FAST)
+     { /* skip the rest of the run in the current
+          block with the vectorized span helpers */
+       long n;
+       switch (state)
+       { case ST_INNUM:
+         case ST_INID:
+           if (state == ST_INNUM)
+             n = spanDigits(inBuf+pos,inBuf+bufsize);
+           else
+             n = spanLetters(inBuf+pos,inBuf+bufsize);
+           while (tokenStringIndex+n+1 >= tokenStringSize)
+             growTokenString();
+           memcpy(tokenString+tokenStringIndex,inBuf+pos,n);
+           tokenStringIndex += n;
+           pos += n;
+           break;
+         case ST_START:
+           /* lines are echoed as they are entered, so
+              with EchoSource stay within the line */
+           if (EchoSource)
+           { if (!lineStart) pos += spanBlanks(inBuf+pos,inBuf+bufsize);
+           }
+           else
+           { n = spanWhite(inBuf+pos,inBuf+bufsize);
+             pos = skipLines(pos,pos+n,&lineStart);
+           }
+           break;
+         case ST_INCOMMENT:
+         { /* stop on the comment terminator, or one
+              char before the end of what is looked
+              at so a terminator split there is
+              still seen by the DFA */
+           const char * limit = inBuf+bufsize;
+           const char * stop;
+           if (EchoSource)
+           { if (lineStart) break;
+             stop = memchr(inBuf+pos,'\n',bufsize-pos);
+             if (stop) limit = stop;
+           }
+           stop = findCommentEnd(inBuf+pos,limit);
+           if (stop == NULL) stop = limit-1;
+           if (stop > inBuf+pos)
+             pos = skipLines(pos,(int) (stop-inBuf),&lineStart);
+           break;
+         }
+         default:
+           break;
+       }
      }
    }
+   linepos = pos;
+   atLineStart = lineStart;
+   if ((next & STATEMASK) == ST_BACKUP) ungetNextChar();
+   tokenString[tokenStringIndex] = '\0';
+   currentToken = acceptToken[state][cl];
+   if (currentToken == ID)
+     currentToken = reservedLookup(tokenString);
    if (TraceScan) {
      fprintf(listing,"\t%d: ",lineno);
      printToken(currentToken,tokenString);
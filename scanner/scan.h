@@ -8,11 +8,11 @@
 #ifndef _SCAN_H_
 #define _SCAN_H_
 
-/* MAXTOKENLEN is the maximum size of a token */
-#define MAXTOKENLEN 40
-
-/* tokenString array stores the lexeme of each token */
-extern char tokenString[MAXTOKENLEN+1];
+/* tokenString stores the lexeme of each token;
+ * it grows as needed and is valid until the next
+ * call of getToken
+ */
+extern char * tokenString;
 
 /* function getToken returns the 
  * next token in source file
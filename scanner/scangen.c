@@ -0,0 +1,185 @@
+/****************************************************/
+/* File: scangen.c                                  */
+/* Generates the transition tables of the scanner   */
+/* DFA as scantab.h at build time                   */
+/****************************************************/
+
+#include "globals.h"
+
+/* the dummy definitions below satisfy globals.h */
+FILE * source;
+FILE * listing;
+FILE * code;
+int lineno;
+int EchoSource, TraceScan, TraceParse, TraceAnalyze, TraceCode, Error;
+
+/* character classes; C_EOF must be 0 since
+ * the class map is indexed by c+1 and EOF is -1
+ */
+typedef enum
+   { C_EOF,C_OTHER,C_DIGIT,C_LETTER,C_WS,C_SLASH,C_STAR,
+     C_EQ,C_LT,C_GT,C_BANG,C_PLUS,C_MINUS,C_LPAREN,C_RPAREN,
+     C_LBRACE,C_RBRACE,C_LCURLY,C_RCURLY,C_SEMI,C_COMMA,
+     NCLASSES
+   } CharClass;
+
+static char * className[NCLASSES] =
+   { "C_EOF","C_OTHER","C_DIGIT","C_LETTER","C_WS","C_SLASH","C_STAR",
+     "C_EQ","C_LT","C_GT","C_BANG","C_PLUS","C_MINUS","C_LPAREN","C_RPAREN",
+     "C_LBRACE","C_RBRACE","C_LCURLY","C_RCURLY","C_SEMI","C_COMMA" };
+
+/* states in scanner DFA; ST_ACCEPT and ST_BACKUP
+ * are final: ST_ACCEPT keeps the last character in
+ * the token, ST_BACKUP gives it back to the input
+ */
+typedef enum
+   { ST_START,ST_INNUM,ST_INID,ST_INOVER,ST_INCOMMENT,ST_INCOMMENT_,
+     ST_INEQ,ST_INLT,ST_INGT,ST_INNE,ST_ACCEPT,ST_BACKUP,
+     NSTATES
+   } StateType;
+
+static char * stateName[NSTATES] =
+   { "ST_START","ST_INNUM","ST_INID","ST_INOVER","ST_INCOMMENT",
+     "ST_INCOMMENT_","ST_INEQ","ST_INLT","ST_INGT","ST_INNE",
+     "ST_ACCEPT","ST_BACKUP" };
+
+/* flags or'ed into a transition entry: SAVE appends
+ * the character to tokenString, RESET empties it,
+ * FAST lets the scanner skip the rest of a run of
+ * white space, comment, letters or digits at once
+ */
+#define STATEMASK 0x1f
+#define FAST 0x20
+#define RESET 0x40
+#define SAVE 0x80
+
+static int charClass[257];
+static int transition[NSTATES][NCLASSES];
+static TokenType acceptToken[NSTATES][NCLASSES];
+
+/* setClass puts every character of s into class cl */
+static void setClass(char * s, CharClass cl)
+{ while (*s) charClass[(unsigned char) *s++ + 1] = cl;
+}
+
+/* move adds the transition on class cl from state
+ * from; tok is the token recognized if to is final
+ */
+static void move(StateType from, CharClass cl, int to, TokenType tok)
+{ transition[from][cl] = to;
+  acceptToken[from][cl] = tok;
+}
+
+/* moveAll adds a transition on every class */
+static void moveAll(StateType from, int to, TokenType tok)
+{ int cl;
+  for (cl=0;cl<NCLASSES;cl++) move(from,cl,to,tok);
+}
+
+static void buildDFA(void)
+{ int c;
+  charClass[0] = C_EOF;
+  for (c=0;c<256;c++)
+  { if (isdigit(c)) charClass[c+1] = C_DIGIT;
+    else if (isalpha(c)) charClass[c+1] = C_LETTER;
+    else charClass[c+1] = C_OTHER;
+  }
+  setClass(" \t\n",C_WS);
+  setClass("/",C_SLASH); setClass("*",C_STAR);
+  setClass("=",C_EQ); setClass("<",C_LT);
+  setClass(">",C_GT); setClass("!",C_BANG);
+  setClass("+",C_PLUS); setClass("-",C_MINUS);
+  setClass("(",C_LPAREN); setClass(")",C_RPAREN);
+  setClass("[",C_LBRACE); setClass("]",C_RBRACE);
+  setClass("{",C_LCURLY); setClass("}",C_RCURLY);
+  setClass(";",C_SEMI); setClass(",",C_COMMA);
+
+  moveAll(ST_START,ST_ACCEPT|SAVE,ERROR);
+  move(ST_START,C_EOF,ST_ACCEPT,ENDFILE);
+  move(ST_START,C_WS,ST_START|FAST,ERROR);
+  move(ST_START,C_DIGIT,ST_INNUM|SAVE|FAST,ERROR);
+  move(ST_START,C_LETTER,ST_INID|SAVE|FAST,ERROR);
+  move(ST_START,C_SLASH,ST_INOVER|SAVE,ERROR);
+  move(ST_START,C_EQ,ST_INEQ|SAVE,ERROR);
+  move(ST_START,C_LT,ST_INLT|SAVE,ERROR);
+  move(ST_START,C_GT,ST_INGT|SAVE,ERROR);
+  move(ST_START,C_BANG,ST_INNE|SAVE,ERROR);
+  move(ST_START,C_STAR,ST_ACCEPT|SAVE,TIMES);
+  move(ST_START,C_PLUS,ST_ACCEPT|SAVE,PLUS);
+  move(ST_START,C_MINUS,ST_ACCEPT|SAVE,MINUS);
+  move(ST_START,C_LPAREN,ST_ACCEPT|SAVE,LPAREN);
+  move(ST_START,C_RPAREN,ST_ACCEPT|SAVE,RPAREN);
+  move(ST_START,C_LBRACE,ST_ACCEPT|SAVE,LBRACE);
+  move(ST_START,C_RBRACE,ST_ACCEPT|SAVE,RBRACE);
+  move(ST_START,C_LCURLY,ST_ACCEPT|SAVE,LCURLY);
+  move(ST_START,C_RCURLY,ST_ACCEPT|SAVE,RCURLY);
+  move(ST_START,C_SEMI,ST_ACCEPT|SAVE,SEMI);
+  move(ST_START,C_COMMA,ST_ACCEPT|SAVE,COMMA);
+
+  moveAll(ST_INNUM,ST_BACKUP,NUM);
+  move(ST_INNUM,C_DIGIT,ST_INNUM|SAVE,ERROR);
+
+  moveAll(ST_INID,ST_BACKUP,ID);
+  move(ST_INID,C_LETTER,ST_INID|SAVE,ERROR);
+
+  moveAll(ST_INOVER,ST_BACKUP,OVER);
+  move(ST_INOVER,C_STAR,ST_INCOMMENT|RESET|FAST,ERROR);
+
+  moveAll(ST_INCOMMENT,ST_INCOMMENT|FAST,ERROR);
+  move(ST_INCOMMENT,C_EOF,ST_ACCEPT,ENDFILE);
+  move(ST_INCOMMENT,C_STAR,ST_INCOMMENT_,ERROR);
+
+  /* a run of stars may end the comment, as in flex */
+  moveAll(ST_INCOMMENT_,ST_INCOMMENT|FAST,ERROR);
+  move(ST_INCOMMENT_,C_EOF,ST_ACCEPT,ENDFILE);
+  move(ST_INCOMMENT_,C_STAR,ST_INCOMMENT_,ERROR);
+  move(ST_INCOMMENT_,C_SLASH,ST_START,ERROR);
+
+  moveAll(ST_INEQ,ST_BACKUP,ASSIGN);
+  move(ST_INEQ,C_EQ,ST_ACCEPT|SAVE,EQ);
+  moveAll(ST_INLT,ST_BACKUP,LT);
+  move(ST_INLT,C_EQ,ST_ACCEPT|SAVE,LE);
+  moveAll(ST_INGT,ST_BACKUP,GT);
+  move(ST_INGT,C_EQ,ST_ACCEPT|SAVE,GE);
+  moveAll(ST_INNE,ST_BACKUP,ERROR);
+  move(ST_INNE,C_EQ,ST_ACCEPT|SAVE,NE);
+}
+
+/* printTable prints tab as a C array of rows of
+ * width entries each, or as a flat array if rows is 0
+ */
+static void printTable(char * decl, int * tab, int rows, int width)
+{ int i, n = rows ? rows*width : 257;
+  printf("static const unsigned char %s = {",decl);
+  for (i=0;i<n;i++)
+  { if (i % width == 0) printf("\n   %s",rows ? "{" : "");
+    printf("%3d",tab[i]);
+    if (rows && i % width == width-1) printf("}");
+    if (i < n-1) printf(",");
+  }
+  printf("\n};\n\n");
+}
+
+int main(void)
+{ int s, cl;
+  int flat[NSTATES*NCLASSES];
+  buildDFA();
+  printf("/* scantab.h -- generated by scangen, do not edit */\n\n");
+  for (cl=0;cl<NCLASSES;cl++) printf("#define %s %d\n",className[cl],cl);
+  printf("#define NCLASSES %d\n\n",NCLASSES);
+  for (s=0;s<NSTATES;s++) printf("#define %s %d\n",stateName[s],s);
+  printf("#define NSTATES %d\n\n",NSTATES);
+  printf("#define STATEMASK 0x%x\n#define FAST 0x%x\n#define RESET 0x%x\n#define SAVE 0x%x\n\n",
+         STATEMASK,FAST,RESET,SAVE);
+  printf("/* class of each character, indexed by c+1 so that EOF maps to C_EOF */\n");
+  printTable("charClass[257]",charClass,0,16);
+  printf("/* next state (and SAVE/RESET/FAST flags) by [state][class] */\n");
+  for (s=0;s<NSTATES;s++)
+    for (cl=0;cl<NCLASSES;cl++) flat[s*NCLASSES+cl] = transition[s][cl];
+  printTable("transition[NSTATES][NCLASSES]",flat,NSTATES,NCLASSES);
+  printf("/* token recognized when [state] moves on [class] to a final state */\n");
+  for (s=0;s<NSTATES;s++)
+    for (cl=0;cl<NCLASSES;cl++) flat[s*NCLASSES+cl] = acceptToken[s][cl];
+  printTable("acceptToken[NSTATES][NCLASSES]",flat,NSTATES,NCLASSES);
+  return 0;
+}
@@ -6,116 +6,211 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <pthread.h>
+#include <unistd.h>
 #include "globals.h"
 #include "symtab.h"
 #include "analyze.h"
 #include "util.h"
+#include "intern.h"
+#include "compact.h"
 
 
 ScopeList global;
 
-static char a[] = "Global";
-static char * funcName = a;
-
-static int flag = 0;
-static int stay = 0;
-
-/* counter for variable memory locations */
-static int location = 0;
+/* scope names are atoms like all other names;
+ * they are interned by buildSymtab
+ */
+static char * globalName;
+static char * ifName;
+static char * elseName;
+static char * whileName;
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
- * it applies preProc in preorder and postProc 
- * in postorder to tree pointed to by t
+/* the tree being analyzed, and the fields of its
+ * node t
  */
-static void traverse( TreeNode * t,
-               void (* preProc) (TreeNode *),
-               void (* postProc) (TreeNode *) )
-{ if (t != NULL)
-  { preProc(t);
-    { int i;
-      for (i=0; i < MAXCHILDREN; i++)
-        traverse(t->child[i],preProc,postProc);
-    }
-    postProc(t);
-    traverse(t->sibling,preProc,postProc);
-  }
+static CompactTree * tree;
+#define NODEKIND(t) (tree->nodekind[t])
+#define KIND(t) (tree->kind[t])
+#define CHILD(t,i) (tree->child[t][i])
+#define SIBLING(t) (tree->sibling[t])
+#define ATTR(t) (tree->attr[t])
+#define TYPE(t) (tree->type[t])
+#define LINENO(t) (tree->lineno[t])
+#define SCOPE(t) (tree->scope[t])
+#define BINDING(t) (tree->binding[t])
+
+/* bind records that node t resolves to the symbol
+ * record b, or to nothing if b is NULL
+ */
+static void bind(NodeId t, BucketList b)
+{ BINDING(t).symbol = b;
+  BINDING(t).depth = b ? b->depth : 0;
+  BINDING(t).slot = b ? b->memloc : 0;
 }
 
-/* nullProc is a do-nothing procedure to 
- * generate preorder-only or postorder-only
- * traversals from traverse
+/* the state of a walk of the tree; each thread
+ * analyzing function bodies side by side has one of
+ * its own (see analyzeBodies), which walkTree hands
+ * the procs as their arg
  */
-static void nullProc(TreeNode * t)
-{ if (t==NULL) return;
-  else return;
-}
+typedef struct
+   { char * funcName; /* the scope declarations go in */
+     /* the record of the function whose body
+      * buildSymtab is in
+      */
+     BucketList funcSymbol;
+     int flag, stay; /* what the next compound statement opens */
+     /* symbol errors go to symListing, which is the
+      * listing but for a thread analyzing bodies
+      */
+     FILE * symListing;
+     /* type errors go to typeListing, which is a
+      * buffer while a fused analysis holds them back
+      * for typeCheck to list; heldErrors counts them
+      * there
+      */
+     FILE * typeListing;
+     char * held;
+     size_t heldSize;
+     int heldErrors;
+     /* undeclared counts the uses of undeclared
+      * names, after which a fused analysis cannot
+      * stand in for typeCheck: that may find a
+      * global declared later
+      */
+     int undeclared;
+     /* the body being analyzed for keeping, if any
+      * (see analyzeKept); its errors are noted, not
+      * listed
+      */
+     struct BodyRec * keeping;
+   } Analysis;
+
+/* the analysis on the calling thread, which lasts
+ * from buildSymtab to typeCheck
+ */
+static Analysis analysis;
 
-static void symbolError(TreeNode *t, char *message){
-  fprintf(listing, "Symbol error at line %d: %s\n",t->lineno, message);
+static void keepNote(Analysis * a, int symbol, NodeId t, char * message);
+static void keepName(Analysis * a, char * name);
+static void startTable(Analysis * a);
+
+static void symbolError(Analysis * a, NodeId t, char *message){
+  if (a->keeping != NULL) keepNote(a, TRUE, t, message);
+  else fprintf(a->symListing, "Symbol error at line %d: %s\n",LINENO(t), message);
 }
 
-static void forPop( TreeNode * t){
-  if(t->nodekind == StmtK){
-    if(t->kind.stmt == CompK){
+static void forPop( NodeId t, void * arg){
+  Analysis * a = (Analysis *) arg;
+  if(NODEKIND(t) == StmtK){
+    if(KIND(t) == CompK){
       scope_pop();
       ScopeList sc = scope_top();
-      funcName = sc->name;
+      a->funcName = sc->name;
     }
   }
 }
 
+/* declareParams gives the function of record b the
+ * parameters in the list at node p, where (void) is
+ * none, so that a call is checked without walking
+ * them
+ */
+static void declareParams(BucketList b, NodeId p)
+{ ExpType * type;
+  NodeId q;
+  int n = 0;
+  for (q = p; q != 0; q = SIBLING(q)) n++;
+  if (n == 1 && TYPE(p) == Void) n = 0;
+  type = st_params(b, n);
+  for (q = p; n > 0; q = SIBLING(q), n--)
+    *type++ = TYPE(q);
+}
+
+/* declareFunction puts the function declared at
+ * node t in the table, returning FALSE if it is
+ * there already
+ */
+static int declareFunction(Analysis * a, NodeId t)
+{ a->funcSymbol = st_lookup_excluding_parent(a->funcName, ATTR(t).name);
+  if(a->funcSymbol) {
+    symbolError(a, t, "function already declared in same scope");
+    bind(t, NULL);
+    return FALSE;
+  }
+
+  a->funcSymbol = st_insert( a->funcName, ATTR(t).name, TYPE(t), LINENO(t), addLocation(), t);
+  bind(t, a->funcSymbol);
+  if (a->funcSymbol->node == t) declareParams(a->funcSymbol, CHILD(t,0));
+  return TRUE;
+}
+
+/* enterFunction opens the scope of the function
+ * declared at node t, which its body shares
+ */
+static void enterFunction(Analysis * a, NodeId t)
+{ scope_push(scope_create(ATTR(t).name));
+  a->funcName = ATTR(t).name;
+
+  a->stay = 1;
+}
+
 /* Procedure insertNode inserts 
  * identifiers stored in t into 
  * the symbol table 
  */
-static void insertNode( TreeNode * t)
-{
-  switch (t->nodekind)
+static void insertNode( NodeId t, void * arg)
+{ Analysis * a = (Analysis *) arg;
+  switch (NODEKIND(t))
   { 
     case StmtK:
-      switch(t->kind.stmt){
+      switch(KIND(t)){
         case IfK:
-          if(t->child[2])
-            flag = 1;
-          funcName = ".if";
+          if(CHILD(t,2))
+            a->flag = 1;
+          a->funcName = ifName;
 
           break;
 
         case WhileK:
-          flag = 3;
+          a->flag = 3;
           break;
 
         case CompK:
           
-          if(stay == 1){
-            stay = 0;
-            flag = 0;
+          if(a->stay == 1){
+            a->stay = 0;
+            a->flag = 0;
           }else{
-            if(flag == 1){
-              flag = 2;
+            if(a->flag == 1){
+              a->flag = 2;
             }
-            else if(flag == 2){
-              funcName = ".else";
-              flag = 0;
+            else if(a->flag == 2){
+              a->funcName = elseName;
+              a->flag = 0;
             }
-            else if(flag == 3){
-              funcName = ".while";
-              flag = 0;
+            else if(a->flag == 3){
+              a->funcName = whileName;
+              a->flag = 0;
             }
-            scope_push(scope_create(funcName));
+            scope_push(scope_create(a->funcName));
           }
-          t->scope = scope_top();
+          SCOPE(t) = scope_top();
 
           break;
 
+        case RetK:
+          bind(t, a->funcSymbol);
+          break;
+
         default:
           break;
       }
       break;
       
     case ExpK:
-      switch(t->kind.exp){
+      switch(KIND(t)){
         case OpK:
           break;
         case ConstK:
@@ -124,12 +219,18 @@ static void insertNode( TreeNode * t)
         case IdK:
         case CallK:
         case ArrIdK:
-          if(st_lookup(t->attr.name)){
-            just_add_line(t->attr.name, t->lineno);
+        {
+          BucketList b = st_lookup(ATTR(t).name);
+          bind(t, b);
+          if(b){
+            if(a->keeping != NULL && b->depth == 0) keepName(a, b->name);
+            just_add_line(b, LINENO(t), t);
           }else{
-            symbolError(t, "Undeclared");
-            break;
+            symbolError(a, t, "Undeclared");
+            a->undeclared++;
           }
+          break;
+        }
         
         default:
           break;
@@ -137,34 +238,27 @@ static void insertNode( TreeNode * t)
       break;
 
     case DecK:
-      switch(t->kind.dec){
+      switch(KIND(t)){
         case FunK:
-
-          if(st_lookup_excluding_parent(funcName, t->attr.name)) {
-            symbolError(t, "function already declared in same scope");
-            break;
-          }
-
-          st_insert( funcName, t->attr.name, t->type, t->lineno, addLocation(), t);
-          scope_push(scope_create(t->attr.name));
-          funcName = t->attr.name;
-
-          stay = 1;
+          if(declareFunction(a, t))
+            enterFunction(a, t);
           break;
 
         case VarK:
 
-          if(st_lookup_excluding_parent(funcName, t->attr.name)){
-            symbolError(t, "Var already declared in same scope");
+          if(st_lookup_excluding_parent(a->funcName, ATTR(t).name)){
+            symbolError(a, t, "Var already declared in same scope");
+            bind(t, NULL);
             break;
           }
-          st_insert( funcName, t->attr.name, t->type, t->lineno, addLocation(), t);
+          bind(t, st_insert( a->funcName, ATTR(t).name, TYPE(t), LINENO(t), addLocation(), t));
           break;
 
         case ParamK:
-          if(t->type != Void){
-            st_insert(funcName, t->attr.name, t->type, t->lineno, addLocation(), t);
+          if(TYPE(t) != Void){
+            bind(t, st_insert(a->funcName, ATTR(t).name, TYPE(t), LINENO(t), addLocation(), t));
           }
+          else bind(t, NULL);
           break;
         
         default:
@@ -177,44 +271,669 @@ static void insertNode( TreeNode * t)
   }
 }
 
-static void inoutput(){
-  
-  TreeNode *input;
+/* inoutput declares the built-in functions, which
+ * have no node and so no parameters
+ */
+static void inoutput(Analysis * a){
+  st_params(st_insert(a->funcName, internString("input"), Integer, 0, addLocation(), 0), 0);
+  st_params(st_insert(a->funcName, internString("output"), Void, 0, addLocation(), 0), 1)[0] = Integer;
+}
 
-  input = newDecNode(VarK);
-  input->type = Integer;
+static void checkNode(NodeId t, void * arg);
 
-  input->kind.dec = FunK;
-  input->attr.name = (char*)malloc(strlen("input")+1);
-  strcpy(input->attr.name, "input");
-  input->child[0] = NULL;
-  input->child[1] = NULL;
+/* fusedPost does the work of both passes as the
+ * walk leaves node t: the declarations come before
+ * the uses in C-, so every name a check needs is
+ * bound by then
+ */
+static void fusedPost(NodeId t, void * arg)
+{ if (NODEKIND(t) == StmtK && KIND(t) == CompK)
+    forPop(t,arg);
+  else checkNode(t,arg);
+}
 
-  
-  TreeNode *output;
+/* openBuffer opens a stream on a buffer in memory */
+static FILE * openBuffer(char ** buf, size_t * size)
+{ FILE * f = open_memstream(buf,size);
+  if (f == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  return f;
+}
 
-  output = newDecNode(VarK);
-  output->type = Void;
+/* walkDecl walks the declaration at node t, but not
+ * its siblings, with insertNode and fusedPost;
+ * a function it only enters, having been declared
+ */
+static void walkDecl(Analysis * a, NodeId t)
+{ int i;
+  if (KIND(t) == FunK) enterFunction(a,t);
+  else insertNode(t,a);
+  for (i=0;i<MAXCHILDREN;i++)
+    walkTree(tree,CHILD(t,i),insertNode,fusedPost,a);
+  fusedPost(t,a);
+}
 
-  output->kind.dec = FunK;
-  output->attr.name = (char*)malloc(strlen("output")+1);
-  strcpy(output->attr.name, "output");
-  output->child[0] = NULL;
-  output->child[1] = NULL;
+/* splitDecls returns the top-level declarations of
+ * the tree, ndecls of them, nfuncs of which declare
+ * functions, or NULL if the tree cannot be split
+ * into them: it must hold only declarations, and
+ * each function a body
+ */
+static NodeId * splitDecls(int * ndecls, int * nfuncs)
+{ NodeId * decls;
+  NodeId t;
+  int i;
+  *ndecls = *nfuncs = 0;
+  for (t=tree->root;t!=0;t=SIBLING(t))
+  { if (NODEKIND(t) != DecK) return NULL;
+    if (KIND(t) == FunK)
+    { NodeId body = CHILD(t,1);
+      if (body == 0 || NODEKIND(body) != StmtK || KIND(body) != CompK)
+        return NULL;
+      ++*nfuncs;
+    }
+    else if (KIND(t) != VarK) return NULL;
+    ++*ndecls;
+  }
+  decls = (NodeId *) malloc((*ndecls+1)*sizeof(NodeId));
+  if (decls == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  for (t=tree->root,i=0;t!=0;t=SIBLING(t),i++)
+    decls[i] = t;
+  return decls;
+}
 
-  st_insert(funcName, input->attr.name, input->type, 0, addLocation(), input);
-  st_insert(funcName, output->attr.name, output->type, 0, addLocation(), output);
+/* declareGlobals puts the ndecls declarations of
+ * Global in the table in order, holding back the
+ * lines added to them so that those the bodies add
+ * can be merged in; the symbol errors for decls[i]
+ * end at preEnd[i] in the buffer *pre
+ */
+static void declareGlobals(Analysis * a, NodeId * decls, int ndecls, char ** pre, long * preEnd)
+{ size_t preSize;
+  FILE * preListing;
+  int i;
+  preListing = a->symListing = openBuffer(pre,&preSize);
+  st_hold_lines(TRUE);
+  for (i=0;i<ndecls;i++)
+  { if (KIND(decls[i]) == FunK) declareFunction(a,decls[i]);
+    else walkDecl(a,decls[i]);
+    preEnd[i] = ftell(preListing);
+  }
+  fclose(preListing);
+  a->symListing = listing;
+}
 
+/* a thread analyzing the bodies of functions first
+ * to last in decls; what it lists for function i
+ * ends at symEnd[i] in its symbol errors and at
+ * typeEnd[i] in its type errors
+ */
+typedef struct
+   { NodeId * decls;
+     int first, last;
+     long * symEnd, * typeEnd;
+     char * sym, * type;
+     size_t symSize, typeSize;
+     Analysis a;
+     SymtabPart part;
+   } Worker;
+
+static void * bodyWorker(void * arg)
+{ Worker * w = (Worker *) arg;
+  Analysis * a = &w->a;
+  int i;
+  memset(a,0,sizeof(Analysis));
+  a->symListing = openBuffer(&w->sym,&w->symSize);
+  a->typeListing = openBuffer(&w->type,&w->typeSize);
+  st_fork(global);
+  for (i=w->first;i<w->last;i++)
+  { NodeId t = w->decls[i];
+    if (KIND(t) == FunK)
+    { /* only globals declared by now are seen */
+      st_visible(t);
+      a->funcSymbol = BINDING(t).symbol;
+      a->flag = 0;
+      walkDecl(a,t);
+    }
+    w->symEnd[i] = ftell(a->symListing);
+    w->typeEnd[i] = ftell(a->typeListing);
+  }
+  st_detach(&w->part);
+  fclose(a->symListing);
+  fclose(a->typeListing);
+  return NULL;
 }
-/* Function buildSymtab constructs the symbol 
- * table by preorder traversal of the syntax tree
+
+/* Function analyzeBodies builds the symbol table
+ * and type checks with the declarations of Global
+ * put in the table first, and the function bodies
+ * then analyzed on up to AnalyzeThreads threads,
+ * each taking a run of them of about the same size;
+ * errors are listed in the order a single walk
+ * would list them. It returns FALSE, having done
+ * nothing, for a tree it cannot split up
+ */
+static int analyzeBodies(Analysis * a)
+{ Worker worker[MAXTHREADS];
+  pthread_t tid[MAXTHREADS];
+  int started[MAXTHREADS];
+  SymtabPart globals;
+  NodeId * decls;
+  long * preEnd, * symEnd, * typeEnd;
+  char * pre = NULL;
+  long total, share, at;
+  int ndecls, nfuncs, n, i, k, w;
+  decls = splitDecls(&ndecls,&nfuncs);
+  if (decls == NULL) return FALSE;
+  n = AnalyzeThreads ? AnalyzeThreads : sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > MAXTHREADS) n = MAXTHREADS;
+  if (n > nfuncs) n = nfuncs;
+  if (n < 2)
+  { free(decls);
+    return FALSE;
+  }
+  preEnd = (long *) malloc(ndecls*sizeof(long));
+  symEnd = (long *) malloc(ndecls*sizeof(long));
+  typeEnd = (long *) malloc(ndecls*sizeof(long));
+  if (preEnd == NULL || symEnd == NULL || typeEnd == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  declareGlobals(a,decls,ndecls,&pre,preEnd);
+  st_detach(&globals);
+
+  /* a run of declarations for each thread; the
+   * nodes of a declaration follow it in the tree
+   */
+  total = tree->nnodes+1 - tree->root;
+  for (w=0,k=0;w<n;w++)
+  { worker[w].decls = decls;
+    worker[w].symEnd = symEnd;
+    worker[w].typeEnd = typeEnd;
+    worker[w].first = k;
+    share = total/n*(w+1);
+    if (w == n-1) k = ndecls;
+    else while (k < ndecls &&
+                (k+1 < ndecls ? (long) decls[k+1] : tree->nnodes+1) - tree->root <= share)
+      k++;
+    worker[w].last = k;
+  }
+  for (w=1;w<n;w++)
+    started[w] = pthread_create(&tid[w],NULL,bodyWorker,&worker[w]) == 0;
+  bodyWorker(&worker[0]);
+  for (w=1;w<n;w++)
+    if (started[w]) pthread_join(tid[w],NULL);
+    else bodyWorker(&worker[w]);
+
+  /* the table in the order of a single walk */
+  st_join(&globals);
+  for (w=0;w<n;w++) st_join(&worker[w].part);
+  st_hold_lines(FALSE);
+  scope_push(global);
+  a->funcName = globalName;
+
+  /* and the errors */
+  for (w=0,i=0;w<n;w++)
+  { long symAt = 0, typeAt = 0;
+    for (;i<worker[w].last;i++)
+    { at = i ? preEnd[i-1] : 0;
+      fwrite(pre+at,1,preEnd[i]-at,listing);
+      fwrite(worker[w].sym+symAt,1,symEnd[i]-symAt,listing);
+      fwrite(worker[w].type+typeAt,1,typeEnd[i]-typeAt,a->typeListing);
+      symAt = symEnd[i];
+      typeAt = typeEnd[i];
+    }
+    a->heldErrors += worker[w].a.heldErrors;
+    a->undeclared += worker[w].a.undeclared;
+    free(worker[w].sym);
+    free(worker[w].type);
+  }
+  free(pre);
+  free(decls);
+  free(preEnd);
+  free(symEnd);
+  free(typeEnd);
+  return TRUE;
+}
+
+/* with KeepAnalysis the analysis of each function
+ * body is kept until the next compile, which uses
+ * it again for a body whose declaration hashes the
+ * same, relative to its first node and line, and
+ * whose uses of Global stand for the same things
+ */
+#define MIX(h,x) ((h) = ((h) ^ (unsigned long long) (x)) * 1099511628211ull)
+#define OFFSET_BASIS 14695981039346656037ull
+
+/* an error found in a kept body, at its node less
+ * that of the declaration plus one, or at no node
+ */
+typedef struct
+   { int symbol; /* TRUE for a symbol error, FALSE for a type error */
+     NodeId node;
+     char * message;
+   } Note;
+
+typedef struct BodyRec
+   { unsigned long long hash; /* of its declaration */
+     unsigned long long uses; /* of what its names of Global stood for */
+     char ** names; /* of Global it uses, its own among them */
+     int nnames, namesCap;
+     Note * notes; /* its errors, in order */
+     int nnotes, notesCap;
+     NodeId node; /* its declaration */
+     int lineno;  /* and that declaration's line */
+     SymtabPart part; /* its scopes */
+     /* what its analysis left in the tree for the
+      * nnodes nodes after its declaration, for the
+      * next tree that takes it
+      */
+     Binding * bindings;
+     struct ScopeListRec ** scopes;
+     unsigned char * types;
+     int nnodes;
+     int taken; /* by the present compile */
+   } Body;
+
+/* the bodies kept, in source order */
+static Body ** kept = NULL;
+static int nkept = 0;
+/* of the bodies of the last compile, how many were
+ * analyzed rather than kept
+ */
+static int bodies = 0, checked = 0;
+
+/* grow doubles the capacity *cap of the array *a of
+ * elements of size bytes
+ */
+static void grow(void * a, int * cap, size_t size)
+{ void * p;
+  *cap = *cap ? *cap*2 : 16;
+  p = realloc(*(void **) a,*cap*size);
+  if (p == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  *(void **) a = p;
+}
+
+static void keepNote(Analysis * a, int symbol, NodeId t, char * message)
+{ Body * b = a->keeping;
+  Note * n;
+  if (b->nnotes == b->notesCap)
+    grow(&b->notes,&b->notesCap,sizeof(Note));
+  n = &b->notes[b->nnotes++];
+  n->symbol = symbol;
+  n->node = t ? t - b->node + 1 : 0;
+  n->message = message;
+}
+
+static void keepName(Analysis * a, char * name)
+{ Body * b = a->keeping;
+  if (b->nnames == b->namesCap)
+    grow(&b->names,&b->namesCap,sizeof(char *));
+  b->names[b->nnames++] = name;
+}
+
+static void freeBody(Body * b)
+{ st_drop(&b->part);
+  free(b->names);
+  free(b->notes);
+  free(b->bindings);
+  free(b->scopes);
+  free(b->types);
+  free(b);
+}
+
+/* declEnd returns the node after the subtree of the
+ * declaration at node f
+ */
+static NodeId declEnd(NodeId f)
+{ return SIBLING(f) ? SIBLING(f) : (NodeId) tree->nnodes+1;
+}
+
+/* saveBody keeps what the analysis of body b left
+ * in the tree for the nodes of its declaration
+ */
+static void saveBody(Body * b)
+{ NodeId f = b->node+1;
+  int n = declEnd(b->node) - f;
+  b->bindings = (Binding *) malloc(n*sizeof(Binding));
+  b->scopes = (struct ScopeListRec **) malloc(n*sizeof(struct ScopeListRec *));
+  b->types = (unsigned char *) malloc(n);
+  if (n > 0 && (b->bindings == NULL || b->scopes == NULL || b->types == NULL))
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  memcpy(b->bindings,&BINDING(f),n*sizeof(Binding));
+  memcpy(b->scopes,&SCOPE(f),n*sizeof(struct ScopeListRec *));
+  memcpy(b->types,&TYPE(f),n);
+  b->nnodes = n;
+}
+
+/* slots of the cache takeBody looks up the records
+ * of Global in, by the record they replace
+ */
+#define TAKECACHE 64
+
+/* takeBody puts what saveBody kept of body b, now
+ * at node b->node, back in the tree; its own scopes
+ * and records are kept with it, but those of Global
+ * are new to this compile, so names bound there
+ * are looked up again, once for each record they
+ * were bound to, and a return is bound to the
+ * function's record
+ */
+static void takeBody(Body * b)
+{ BucketList was[TAKECACHE];
+  Binding now[TAKECACHE];
+  NodeId f = b->node+1, t;
+  memcpy(&BINDING(f),b->bindings,b->nnodes*sizeof(Binding));
+  memcpy(&SCOPE(f),b->scopes,b->nnodes*sizeof(struct ScopeListRec *));
+  memcpy(&TYPE(f),b->types,b->nnodes);
+  memset(was,0,sizeof(was));
+  for (t=f;t<f+b->nnodes;t++)
+    if (BINDING(t).symbol != NULL && BINDING(t).depth == 0)
+    { /* the old record is only compared, its table is gone */
+      BucketList old = BINDING(t).symbol;
+      int k = ((size_t) old >> 4) % TAKECACHE;
+      if (was[k] != old)
+      { was[k] = old;
+        if (NODEKIND(t) == StmtK && KIND(t) == RetK)
+          bind(t, BINDING(b->node).symbol);
+        else bind(t, st_lookup(ATTR(t).name));
+        now[k] = BINDING(t);
+      }
+      else BINDING(t) = now[k];
+    }
+}
+
+/* named tells whether the attr of node t is a name */
+static int named(NodeId t)
+{ switch (NODEKIND(t))
+  { case DecK: return TRUE;
+    case ExpK: return KIND(t)==IdK || KIND(t)==CallK || KIND(t)==ArrIdK;
+    default: return FALSE;
+  }
+}
+
+/* hashDecl hashes the subtree of the declaration at
+ * node f, with its nodes and lines taken from f's;
+ * shapes and attrs go into two hashes, which do not
+ * wait on each other
  */
-void buildSymtab(TreeNode * syntaxTree)
-{
-  global = scope_create(funcName);
+static unsigned long long hashDecl(NodeId f)
+{ unsigned long long h = OFFSET_BASIS, g = OFFSET_BASIS;
+  NodeId end = declEnd(f), t;
+  int i;
+  for (t=f;t<end;t++)
+  { unsigned shape = NODEKIND(t) | KIND(t)<<8 | TYPE(t)<<16;
+    for (i=0;i<MAXCHILDREN;i++)
+      if (CHILD(t,i)) shape |= 1u << (24+i);
+    if (t != f && SIBLING(t)) shape |= 1u << 31;
+    MIX(h,shape | (unsigned long long) (LINENO(t)-LINENO(f)) << 32);
+    if (named(t)) MIX(g,(size_t) ATTR(t).name);
+    else MIX(g,(unsigned) ATTR(t).val | (unsigned long long) tree->size[t] << 32);
+  }
+  MIX(h,g);
+  return h ^ (h >> 32);
+}
+
+/* signature hashes what name stands for in Global,
+ * as far as the checks of a body go: the type of its
+ * record and the types of its parameters
+ */
+static unsigned long long signature(char * name)
+{ unsigned long long h = OFFSET_BASIS;
+  BucketList b = st_lookup(name);
+  int i;
+  if (b == NULL) return 0;
+  MIX(h,b->type);
+  MIX(h,b->arity);
+  for (i=0;i<b->arity;i++)
+    MIX(h,b->params[i]);
+  return h;
+}
+
+static unsigned long long usesHash(Body * b)
+{ unsigned long long h = OFFSET_BASIS;
+  int i;
+  for (i=0;i<b->nnames;i++)
+    MIX(h,signature(b->names[i]));
+  return h;
+}
+
+static int byName(const void * a, const void * b)
+{ char * x = *(char * const *) a, * y = *(char * const *) b;
+  return x < y ? -1 : x > y;
+}
+
+/* Function analyzeKept builds the symbol table and
+ * type checks as analyzeBodies does, but on this
+ * thread, and only for the bodies that cannot be
+ * kept from the last compile. It returns FALSE,
+ * having left the table as buildSymtab started it,
+ * for a tree it cannot split up, or one that uses
+ * undeclared names, which buildSymtab then walks
+ * in full
+ */
+static int analyzeKept(Analysis * a)
+{ SymtabPart globals;
+  NodeId * decls;
+  Body ** body;
+  long * preEnd;
+  char * pre = NULL;
+  int * index;
+  int mask = 15;
+  int ndecls, nfuncs, i, j, n;
+  long at;
+  decls = splitDecls(&ndecls,&nfuncs);
+  if (decls == NULL) return FALSE;
+  preEnd = (long *) malloc(ndecls*sizeof(long));
+  body = (Body **) calloc(ndecls,sizeof(Body *));
+  while (mask < 2*nkept) mask = 2*mask+1;
+  index = (int *) malloc((mask+1)*sizeof(int));
+  if (preEnd == NULL || body == NULL || index == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  declareGlobals(a,decls,ndecls,&pre,preEnd);
+
+  /* the bodies kept, by hash */
+  for (i=0;i<=mask;i++) index[i] = -1;
+  for (i=0;i<nkept;i++)
+  { j = kept[i]->hash & mask;
+    while (index[j] >= 0) j = (j+1) & mask;
+    index[j] = i;
+    kept[i]->taken = FALSE;
+  }
+  bodies = nfuncs;
+  checked = 0;
+  for (i=0;i<ndecls;i++)
+  { NodeId t = decls[i];
+    unsigned long long h;
+    if (KIND(t) != FunK) continue;
+    h = hashDecl(t);
+    st_visible(t);
+    for (j = h & mask; index[j] >= 0; j = (j+1) & mask)
+    { Body * b = kept[index[j]];
+      if (b->hash == h && !b->taken && usesHash(b) == b->uses)
+      { st_rebase(&b->part,t - b->node,LINENO(t) - b->lineno);
+        b->node = t;
+        b->lineno = LINENO(t);
+        b->taken = TRUE;
+        takeBody(b);
+        body[i] = b;
+        break;
+      }
+    }
+    if (body[i] == NULL)
+    { body[i] = (Body *) calloc(1,sizeof(Body));
+      if (body[i] == NULL)
+      { fprintf(listing,"Out of memory error\n");
+        exit(1);
+      }
+      body[i]->hash = h;
+      body[i]->node = t;
+      body[i]->lineno = LINENO(t);
+    }
+  }
+  st_visible(0);
+  st_detach(&globals);
+
+  /* analyze the others, each in a part of its own */
+  for (i=0;i<ndecls;i++)
+    if (body[i] != NULL && !body[i]->taken)
+    { NodeId t = decls[i];
+      a->keeping = body[i];
+      st_fork(global);
+      st_visible(t);
+      a->funcSymbol = BINDING(t).symbol;
+      keepName(a,a->funcSymbol->name);
+      a->flag = 0;
+      walkDecl(a,t);
+      st_detach(&a->keeping->part);
+      saveBody(a->keeping);
+      checked++;
+    }
+  a->keeping = NULL;
+  st_join(&globals);
+  if (a->undeclared > 0)
+  { for (i=0;i<ndecls;i++)
+      if (body[i] != NULL && !body[i]->taken) freeBody(body[i]);
+    startTable(a);
+    for (i=1;i<=tree->nnodes;i++)
+      if (NODEKIND(i) == ExpK) TYPE(i) = Void;
+    checked = bodies;
+    free(pre);
+    free(decls);
+    free(preEnd);
+    free(body);
+    free(index);
+    return FALSE;
+  }
+
+  /* the table in the order of a single walk */
+  for (i=0;i<ndecls;i++)
+    if (body[i] != NULL) st_share(&body[i]->part);
+  st_hold_lines(FALSE);
   scope_push(global);
-  inoutput();
-  traverse(syntaxTree,insertNode,forPop);
+  a->funcName = globalName;
+
+  /* keep the bodies of this compile */
+  for (i=0;i<nkept;i++)
+    if (!kept[i]->taken) freeBody(kept[i]);
+  for (i=0,n=0;i<ndecls;i++)
+    if (body[i] != NULL)
+    { Body * b = body[i];
+      if (!b->taken)
+      { int k;
+        qsort(b->names,b->nnames,sizeof(char *),byName);
+        for (j=0,k=0;j<b->nnames;j++)
+          if (k == 0 || b->names[j] != b->names[k-1])
+            b->names[k++] = b->names[j];
+        b->nnames = k;
+        st_visible(decls[i]);
+        b->uses = usesHash(b);
+      }
+      body[n++] = b;
+    }
+  st_visible(0);
+  free(kept);
+  kept = body;
+  nkept = n;
+
+  /* and list the errors */
+  for (i=0,n=0;i<ndecls;i++)
+  { at = i ? preEnd[i-1] : 0;
+    fwrite(pre+at,1,preEnd[i]-at,listing);
+    if (KIND(decls[i]) == FunK)
+    { Body * b = kept[n++];
+      for (j=0;j<b->nnotes;j++)
+      { Note * note = &b->notes[j];
+        int line = note->node ? LINENO(b->node + note->node-1) : 0;
+        if (note->symbol)
+          fprintf(listing,"Symbol error at line %d: %s\n",line,note->message);
+      }
+      for (j=0;j<b->nnotes;j++)
+      { Note * note = &b->notes[j];
+        int line = note->node ? LINENO(b->node + note->node-1) : 0;
+        if (!note->symbol)
+        { fprintf(a->typeListing,"Type error at line %d: %s\n",line,note->message);
+          a->heldErrors++;
+        }
+      }
+    }
+  }
+  free(pre);
+  free(decls);
+  free(preEnd);
+  free(index);
+  return TRUE;
+}
+
+/* dropKept drops the bodies kept */
+static void dropKept(void)
+{ int i;
+  for (i=0;i<nkept;i++) freeBody(kept[i]);
+  free(kept);
+  kept = NULL;
+  nkept = 0;
+}
+
+int bodiesChecked(int * total)
+{ *total = bodies;
+  return checked;
+}
+
+/* startTable starts the table with just the scope of
+ * Global, holding the built-in functions
+ */
+static void startTable(Analysis * a)
+{ a->funcName = globalName;
+  a->funcSymbol = NULL;
+  a->flag = 0;
+  a->stay = 0;
+  a->undeclared = 0;
+  st_reset();
+  global = scope_create(a->funcName);
+  scope_push(global);
+  inoutput(a);
+}
+
+/* Function buildSymtab constructs the symbol 
+ * table by preorder traversal of the syntax tree;
+ * with FuseAnalysis it type checks in the same walk
+ */
+void buildSymtab(CompactTree * syntaxTree)
+{ Analysis * a = &analysis;
+  tree = syntaxTree;
+  globalName = internString("Global");
+  ifName = internString(".if");
+  elseName = internString(".else");
+  whileName = internString(".while");
+  startTable(a);
+  if (a->typeListing != NULL && a->typeListing != listing)
+    fclose(a->typeListing);
+  free(a->held);
+  a->held = NULL;
+  a->typeListing = listing;
+  a->symListing = listing;
+  bodies = checked = 0;
+  if (! (FuseAnalysis && KeepAnalysis)) dropKept();
+  if (FuseAnalysis)
+  { a->typeListing = openBuffer(&a->held,&a->heldSize);
+    a->heldErrors = 0;
+    if (! (KeepAnalysis && analyzeKept(a)) &&
+        (AnalyzeThreads == 1 || !analyzeBodies(a)))
+      walkTree(tree,tree->root,insertNode,fusedPost,a);
+  }
+  else walkTree(tree,tree->root,insertNode,forPop,a);
 
   scope_pop();
 
@@ -224,9 +943,14 @@ void buildSymtab(TreeNode * syntaxTree)
   }
 }
 
-static void typeError(TreeNode * t, char * message)
-{ fprintf(listing,"Type error at line %d: %s\n",t->lineno,message);
-  Error = TRUE;
+static void typeError(Analysis * a, NodeId t, char * message)
+{ if (a->keeping != NULL)
+  { keepNote(a,FALSE,t,message);
+    return;
+  }
+  fprintf(a->typeListing,"Type error at line %d: %s\n",LINENO(t),message);
+  if (a->typeListing == listing) Error = TRUE;
+  else a->heldErrors++;
 }
 
 
@@ -235,21 +959,14 @@ static void typeError(TreeNode * t, char * message)
  * type checking at a single tree node
  */
 
-static void forPush (TreeNode *t){
-  switch (t->nodekind)
+static void forPush (NodeId t, void * arg){
+  (void) arg;
+  switch (NODEKIND(t))
   { 
     case StmtK:
-      switch(t->kind.stmt){
-        case IfK:
-          //funcName = strcat(funcName, ".IF");
-          break;
-
-        case WhileK:
-          //funcName = strcat(funcName, ".WHILE");
-          break;
-
+      switch(KIND(t)){
         case CompK:
-          scope_push(t->scope);
+          scope_push(SCOPE(t));
 
           break;
 
@@ -258,50 +975,51 @@ static void forPush (TreeNode *t){
       }
       break;
 
-    case DecK:
-      switch(t->kind.dec){
-        case FunK:
-          funcName = t->attr.name;
-          break;
-      }
-      break;
-
     default:
       break;
   }
 }
-static void checkNode(TreeNode * t)
-{ 
-  //fprintf(listing, "%d\n", t->lineno);
-switch (t->nodekind)
+/* symbolOf returns the record the name at node t
+ * is bound to; only when names were undeclared,
+ * and a second walk may find them declared later,
+ * are they looked up here
+ */
+static BucketList symbolOf(Analysis * a, NodeId t)
+{ BucketList b = BINDING(t).symbol;
+  if (b == NULL && a->undeclared > 0) b = st_lookup(ATTR(t).name);
+  return b;
+}
+
+static void checkNode(NodeId t, void * arg)
+{ Analysis * a = (Analysis *) arg;
+switch (NODEKIND(t))
   {
 
     case StmtK:
-      switch (t->kind.stmt)
+      switch (KIND(t))
       { 
         case IfK:
-          if(t->child[0]->type == Void)
-            typeError(t->child[0], "void is only available for function");
+          if(TYPE(CHILD(t,0)) == Void)
+            typeError(a, CHILD(t,0), "void is only available for function");
           break;
 
         case WhileK:
-          if(t->child[0]->type == Void)
-            typeError(t->child[0], "void is only available for function");
+          if(TYPE(CHILD(t,0)) == Void)
+            typeError(a, CHILD(t,0), "void is only available for function");
           break;
 
         case CompK:
           scope_pop();
-          funcName = scope_top()->name;
           break;
 
         case RetK:
         {
-          ExpType FuncType = st_lookup(funcName)->type;
+          ExpType FuncType = BINDING(t).symbol->type;
 
-          if(FuncType == Void && (t->child[0] != NULL || t->child[0]->type != Void))
-            typeError(t, "void Function should return void");
-          else if(FuncType == Integer && (t->child[0] == NULL || t->child[0]->type != Integer))
-            typeError(t, "integer Function should return integer");
+          if(FuncType == Void && (CHILD(t,0) != 0 || TYPE(CHILD(t,0)) != Void))
+            typeError(a, t, "void Function should return void");
+          else if(FuncType == Integer && (CHILD(t,0) == 0 || TYPE(CHILD(t,0)) != Integer))
+            typeError(a, t, "integer Function should return integer");
           break;
         }
         default:
@@ -311,105 +1029,105 @@ switch (t->nodekind)
 
     case ExpK:
 
-      switch (t->kind.exp)
+      switch (KIND(t))
       { 
         case OpK:{
           
-          ExpType left = t->child[0]->type;
-          ExpType right = t->child[1]->type;
-          TokenType op = t->attr.op;
+          ExpType left = TYPE(CHILD(t,0));
+          ExpType right = TYPE(CHILD(t,1));
+          TokenType op = ATTR(t).op;
 
           if( left == Void ){
-              typeError(t->child[0], "void is only available for function");
+              typeError(a, CHILD(t,0), "void is only available for function");
             }
           if( right == Void ){
-            typeError(t->child[1], "void is only available for function");
+            typeError(a, CHILD(t,1), "void is only available for function");
           }
           
           if(op == ASSIGN){
             if( left != right ){
-              typeError(t->child[0], "two operands should be same type when assign");
+              typeError(a, CHILD(t,0), "two operands should be same type when assign");
             }
             else
-              t->type = t->child[0]->type;
+              TYPE(t) = TYPE(CHILD(t,0));
           }else{
             if( left != right ){
-              typeError(t->child[0], "two operands should be same type");
+              typeError(a, CHILD(t,0), "two operands should be same type");
             }
             else if(left == Array && right == Array)
-              typeError(t, "two operands shoud not be array");
+              typeError(a, t, "two operands shoud not be array");
 
             else if(op == MINUS && left == Integer && right == Array)
-              typeError(t, "minus no int - array");
+              typeError(a, t, "minus no int - array");
             
             else if( (op == TIMES || op == OVER) && (left == Array || right == Array) )
-              typeError(t, "no times or over in array");
+              typeError(a, t, "no times or over in array");
             
             else
-              t->type = Integer;
+              TYPE(t) = Integer;
           }
           break;
         }
         case ConstK:
-          t->type = Integer;
+          TYPE(t) = Integer;
           break;
 
         case IdK:{
 
-          BucketList b = st_lookup(t->attr.name);
+          BucketList b = symbolOf(a, t);
           if(b == NULL){
             break;
           }
 
-          t->type = b->type;
+          TYPE(t) = b->type;
           break;
           }
 
         case ArrIdK:{
-          BucketList b = st_lookup(t->attr.name);
+          BucketList b = symbolOf(a, t);
           
           if(b == NULL){
             break;
           }
 
-          if(t->child[0]->type != Integer)
-            typeError(t->child[0], "exp should be Integer");
+          if(TYPE(CHILD(t,0)) != Integer)
+            typeError(a, CHILD(t,0), "exp should be Integer");
           else{
-            t->type = Integer;
+            TYPE(t) = Integer;
           }
 
           break;
         }
 
         case CallK:{
-          BucketList b = st_lookup(t->attr.name);
+          BucketList b = symbolOf(a, t);
           
           if(b == NULL)
             break;
 
-          TreeNode *args = t->child[0];
-          TreeNode *params = b->treenode->child[0];
+          NodeId args = CHILD(t,0);
+          int i;
 
-          while(params != NULL){
-            if(args == NULL){
-              typeError(args, "num(args) and num(params) should be same");
+          /* only functions have parameters to match */
+          for(i = 0; i < b->arity; i++){
+            if(args == 0){
+              typeError(a, t, "num(args) and num(params) should be same");
               break;
             }
-            else if(args->type == Void){
-              typeError(args, "void is only available for function");
+            else if(TYPE(args) == Void){
+              typeError(a, args, "void is only available for function");
               break;
             }
-            else if(args->type != params->type){
-              typeError(args, "args and params should have same type");
+            else if(TYPE(args) != b->params[i]){
+              typeError(a, args, "args and params should have same type");
               break;
             }
-            else{
-              args = args->sibling;
-              params = params->sibling;
-            }
+            args = SIBLING(args);
           }
+          if(i == b->arity && args != 0)
+            typeError(a, t, "num(args) and num(params) should be same");
 
-          t->type = b->type;
+          TYPE(t) = b->type;
           break;
         }
 
@@ -428,11 +1146,32 @@ switch (t->nodekind)
 }
 
 /* Procedure typeCheck performs type checking 
- * by a postorder syntax tree traversal
+ * by a postorder syntax tree traversal, or lists
+ * the type errors buildSymtab found if it has
+ * checked already
  */
-void typeCheck(TreeNode * syntaxTree)
-{ 
+void typeCheck(CompactTree * syntaxTree)
+{ Analysis * a = &analysis;
+  NodeId t;
+  tree = syntaxTree;
+  if (a->typeListing != listing && a->typeListing != NULL)
+  { fclose(a->typeListing);
+    a->typeListing = listing;
+    if (a->undeclared == 0)
+    { fwrite(a->held,1,a->heldSize,listing);
+      if (a->heldErrors > 0) Error = TRUE;
+      free(a->held);
+      a->held = NULL;
+      return;
+    }
+    free(a->held);
+    a->held = NULL;
+    /* check again from scratch */
+    for (t=1;t<=(NodeId) tree->nnodes;t++)
+      if (NODEKIND(t) == ExpK) TYPE(t) = Void;
+  }
+  a->typeListing = listing;
   scope_push(global);
-  traverse(syntaxTree,forPush,checkNode);
+  walkTree(tree,tree->root,forPush,checkNode,a);
   scope_pop();
 }
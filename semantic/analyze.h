@@ -9,9 +9,17 @@
 #define _ANALYZE_H_
 
 /* Function buildSymtab constructs the symbol 
- * table by preorder traversal of the syntax tree
+ * table by preorder traversal of the syntax tree,
+ * in compact form (see compact.h)
  */
-void buildSymtab(TreeNode *);
-void typeCheck(TreeNode *);
+void buildSymtab(CompactTree *);
+void typeCheck(CompactTree *);
+
+/* Function bodiesChecked returns how many function
+ * bodies the last buildSymtab analyzed, of *total;
+ * with KeepAnalysis the others were kept from the
+ * compile before
+ */
+int bodiesChecked(int * total);
 
 #endif
@@ -0,0 +1,88 @@
+/****************************************************/
+/* File: arena.c                                    */
+/* Arena allocator for the C- compiler              */
+/* Records are never freed one by one: a request    */
+/* just moves a pointer, and the chunks go back to  */
+/* malloc together when the arena is freed          */
+/****************************************************/
+
+#include "globals.h"
+#include "arena.h"
+
+/* size of the first chunk, and the most a chunk grows to */
+#define FIRSTCHUNK (64*1024)
+#define MAXCHUNK (16*1024*1024)
+
+/* every request is rounded up to this */
+#define ALIGN 16
+
+typedef struct ChunkRec
+   { struct ChunkRec * next;
+     size_t size;
+   } Chunk;
+
+/* the header is padded so that data stays aligned */
+#define HEADER ((sizeof(Chunk)+ALIGN-1) & ~(size_t) (ALIGN-1))
+
+Arena * newArena(void)
+{ Arena * a = (Arena *) calloc(1,sizeof(Arena));
+  if (a != NULL) a->chunkSize = FIRSTCHUNK;
+  return a;
+}
+
+/* grow starts a new chunk of a with room for n
+ * bytes; the rest of the old one is given up
+ */
+static int grow(Arena * a, size_t n)
+{ size_t size = a->chunkSize;
+  Chunk * k;
+  if (size < HEADER+n) size = HEADER+n;
+  else if (a->chunkSize < MAXCHUNK) a->chunkSize *= 2;
+  k = (Chunk *) malloc(size);
+  if (k == NULL) return FALSE;
+  k->size = size;
+  k->next = a->chunks;
+  a->chunks = k;
+  a->next = (char *) k + HEADER;
+  a->end = (char *) k + size;
+  return TRUE;
+}
+
+void * arenaAlloc(Arena * a, size_t n)
+{ void * p;
+  n = (n+ALIGN-1) & ~(size_t) (ALIGN-1);
+  if ((size_t) (a->end - a->next) < n && !grow(a,n)) return NULL;
+  p = a->next;
+  a->next += n;
+  return p;
+}
+
+void joinArena(Arena * into, Arena * from)
+{ Chunk * k = from->chunks;
+  if (k != NULL)
+  { /* from's chunks go behind the current one of into */
+    while (k->next != NULL) k = k->next;
+    if (into->chunks == NULL)
+    { into->chunks = from->chunks;
+      into->next = from->next;
+      into->end = from->end;
+    }
+    else
+    { k->next = into->chunks->next;
+      into->chunks->next = from->chunks;
+    }
+  }
+  from->chunks = NULL;
+  from->next = from->end = NULL;
+  from->spareNodes = NULL;
+}
+
+void freeArena(Arena * a)
+{ Chunk * k, * next;
+  if (a == NULL) return;
+  for (k = a->chunks; k != NULL; k = next)
+  { next = k->next;
+    free(k);
+  }
+  free(a);
+}
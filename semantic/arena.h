@@ -0,0 +1,46 @@
+/****************************************************/
+/* File: arena.h                                    */
+/* Arena allocator for the C- compiler: memory that */
+/* lives as long as a compilation is handed out of  */
+/* large chunks and given back all at once          */
+/****************************************************/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+/* an arena bumps a pointer through its current
+ * chunk; each new chunk is twice the size of the
+ * one before, up to a limit
+ */
+struct ArenaRec
+   { struct ChunkRec * chunks; /* most recent first */
+     char * next, * end; /* free space in the current chunk */
+     size_t chunkSize;   /* size of the next chunk */
+     void * spareNodes;  /* nodes given back by freeTree (see util.h) */
+   };
+
+/* Function newArena returns an empty arena, or NULL
+ * if out of memory
+ */
+Arena * newArena(void);
+
+/* Function arenaAlloc returns n bytes from arena a,
+ * suitably aligned for any record of the compiler,
+ * or NULL if out of memory
+ */
+void * arenaAlloc(Arena * a, size_t n);
+
+/* Procedure joinArena moves all memory of arena from
+ * into arena into, leaving from empty; what was
+ * allocated from either now lives as long as into
+ */
+void joinArena(Arena * into, Arena * from);
+
+/* Procedure freeArena frees a and all memory taken
+ * from it, a chunk at a time
+ */
+void freeArena(Arena * a);
+
+#endif
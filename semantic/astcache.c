@@ -0,0 +1,320 @@
+/****************************************************/
+/* File: astcache.c                                 */
+/* On-disk cache of syntax trees for the C-         */
+/* compiler                                         */
+/* A cache file is a header, the arrays of a        */
+/* compact tree one after the other, each on an     */
+/* 8-byte boundary, and then the names the tree     */
+/* uses; a name is kept in the attr array as its    */
+/* index among them plus one                        */
+/****************************************************/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "globals.h"
+#include "compact.h"
+#include "intern.h"
+#include "astcache.h"
+
+/* the magic number of a cache file, with a version
+ * that changes along with the layout
+ */
+#define MAGIC "CMAST02"
+
+typedef struct
+   { char magic[8];
+     unsigned long long hash; /* of the source text */
+     unsigned long long check; /* its second hash */
+     long sourceSize;
+     int nnodes;
+     NodeId root;
+     int nnames;
+     long nameBytes;
+   } CacheHeader;
+
+/* the sections of a cache file, in order */
+enum { NODEKIND, KIND, TYPE, CHILD, SIBLING, LINENO, SIZE, ATTR, NAMES, NSECTIONS };
+
+/* layout sets off[i] to where section i starts in
+ * the file of a tree of nnodes nodes with nameBytes
+ * bytes of names, and returns the size of the file
+ */
+static size_t layout(int nnodes, long nameBytes, size_t off[])
+{ size_t n = nnodes+1, at = sizeof(CacheHeader);
+  size_t bytes[NSECTIONS];
+  int i;
+  bytes[NODEKIND] = bytes[KIND] = bytes[TYPE] = n;
+  bytes[CHILD] = n*sizeof(NodeId[MAXCHILDREN]);
+  bytes[SIBLING] = n*sizeof(NodeId);
+  bytes[LINENO] = bytes[SIZE] = n*sizeof(int);
+  bytes[ATTR] = n*sizeof(Attr);
+  bytes[NAMES] = nameBytes;
+  for (i=0;i<NSECTIONS;i++)
+  { at = (at+7) & ~(size_t) 7;
+    off[i] = at;
+    at += bytes[i];
+  }
+  return at;
+}
+
+/* hasName tells whether the attr of node t is a name */
+static int hasName(CompactTree * tree, NodeId t)
+{ switch (tree->nodekind[t])
+  { case DecK: return TRUE;
+    case ExpK:
+      return tree->kind[t]==IdK || tree->kind[t]==CallK ||
+             tree->kind[t]==ArrIdK;
+    default: return FALSE;
+  }
+}
+
+/* cacheFile returns the name of the cache file for
+ * hash in directory dir, followed by suffix, in a
+ * buffer the caller frees
+ */
+static char * cacheFile(const char * dir, unsigned long long hash,
+                        const char * suffix)
+{ size_t n = strlen(dir) + strlen("/0123456789abcdef.ast") + strlen(suffix) + 1;
+  char * name = (char *) malloc(n);
+  int k;
+  if (name == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  k = snprintf(name,n,"%s/%016llx.ast%s",dir,hash,suffix);
+  if (k < 0 || (size_t) k >= n)
+  { /* cannot happen, but a cut name could name another file */
+    fprintf(listing,"Cache file name error\n");
+    exit(1);
+  }
+  return name;
+}
+
+/* FNV-1a taken a word at a time, with the high bits
+ * folded back down after each multiply so that they
+ * reach the low ones; the check adds each word
+ * instead, with other constants, in a chain of its
+ * own that runs alongside
+ */
+unsigned long long sourceHash(const char * s, long size,
+                              unsigned long long * check)
+{ unsigned long long h = 14695981039346656037ull ^ (unsigned long long) size;
+  unsigned long long c = 0x9e3779b97f4a7c15ull + (unsigned long long) size;
+  unsigned long long w;
+  long i;
+  for (i=0;i+8<=size;i+=8)
+  { memcpy(&w,s+i,8);
+    h = (h ^ w) * 1099511628211ull;
+    h ^= h >> 29;
+    c = (c + w) * 0xff51afd7ed558ccdull;
+    c ^= c >> 33;
+  }
+  for (;i<size;i++)
+  { h = (h ^ (unsigned char) s[i]) * 1099511628211ull;
+    c = (c + (unsigned char) s[i]) * 0xc4ceb9fe1a85ec53ull;
+  }
+  *check = c ^ (c >> 31);
+  return h ^ (h >> 32);
+}
+
+CompactTree * loadCachedTree(const char * dir, unsigned long long hash,
+                             unsigned long long check, long size)
+{ char * name;
+  struct stat st;
+  size_t off[NSECTIONS];
+  CacheHeader * h;
+  CompactTree * tree;
+  char ** names = NULL;
+  char * p, * end, * image;
+  NodeId t;
+  int fd, i, n;
+  name = cacheFile(dir,hash,"");
+  fd = open(name,O_RDONLY);
+  free(name);
+  if (fd < 0) return NULL;
+  if (fstat(fd,&st) < 0 || (size_t) st.st_size < sizeof(CacheHeader))
+  { close(fd);
+    return NULL;
+  }
+  /* private, so that type checking can write the
+   * type array without touching the file
+   */
+  image = mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (image == MAP_FAILED) return NULL;
+  h = (CacheHeader *) image;
+  n = h->nnodes;
+  if (memcmp(h->magic,MAGIC,sizeof(h->magic)) != 0 ||
+      h->hash != hash || h->check != check || h->sourceSize != size ||
+      n < 0 || h->root > (NodeId) n || h->nnames < 0 || h->nnames > h->nameBytes ||
+      layout(n,h->nameBytes,off) != (size_t) st.st_size)
+    goto bad;
+  tree = (CompactTree *) calloc(1,sizeof(CompactTree));
+  names = (char **) malloc((h->nnames+1)*sizeof(char *));
+  if (tree == NULL || names == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  tree->nnodes = n;
+  tree->root = h->root;
+  tree->nodekind = (unsigned char *) (image+off[NODEKIND]);
+  tree->kind = (unsigned char *) (image+off[KIND]);
+  tree->type = (unsigned char *) (image+off[TYPE]);
+  tree->child = (NodeId (*)[MAXCHILDREN]) (image+off[CHILD]);
+  tree->sibling = (NodeId *) (image+off[SIBLING]);
+  tree->lineno = (int *) (image+off[LINENO]);
+  tree->size = (int *) (image+off[SIZE]);
+  tree->attr = (Attr *) (image+off[ATTR]);
+  tree->image = image;
+  tree->imageSize = st.st_size;
+  /* intern each name once, then put the names in
+   * place of their indices
+   */
+  p = image+off[NAMES];
+  end = p+h->nameBytes;
+  for (i=0;i<h->nnames;i++)
+  { char * nul = memchr(p,'\0',end-p);
+    if (nul == NULL) goto badTree;
+    names[i] = intern(p,nul-p);
+    p = nul+1;
+  }
+  for (t=0;t<=(NodeId) n;t++)
+  { for (i=0;i<MAXCHILDREN;i++)
+      if (tree->child[t][i] > (NodeId) n) goto badTree;
+    if (tree->sibling[t] > (NodeId) n) goto badTree;
+    if (hasName(tree,t))
+    { int k = tree->attr[t].val;
+      if (k < 0 || k > h->nnames) goto badTree;
+      tree->attr[t].name = k ? names[k-1] : NULL;
+    }
+  }
+  tree->scope = (struct ScopeListRec **) calloc(n+1,sizeof(struct ScopeListRec *));
+  tree->binding = (Binding *) calloc(n+1,sizeof(Binding));
+  if (tree->scope == NULL || tree->binding == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  free(names);
+  return tree;
+badTree:
+  free(tree);
+bad:
+  free(names);
+  munmap(image,st.st_size);
+  return NULL;
+}
+
+/* the names of a tree being saved: an open hash
+ * table from interned names to their indices, and
+ * the names in order of index
+ */
+typedef struct
+   { char ** key;
+     int * index;
+     unsigned mask;
+     char ** names;
+     int nnames;
+     long nameBytes;
+   } NameTable;
+
+/* nameIndex returns the index plus one of name s in
+ * table nt, adding it if it is new
+ */
+static int nameIndex(NameTable * nt, char * s)
+{ unsigned i = (unsigned) (((size_t) s >> 4) * 2654435761u) & nt->mask;
+  while (nt->key[i] != NULL)
+  { if (nt->key[i] == s) return nt->index[i];
+    i = (i+1) & nt->mask;
+  }
+  nt->key[i] = s;
+  nt->names[nt->nnames] = s;
+  nt->nameBytes += strlen(s)+1;
+  return nt->index[i] = ++nt->nnames;
+}
+
+/* writeSection writes the n bytes at p to f at
+ * offset off, padding up to it with zeros
+ */
+static void writeSection(FILE * f, const void * p, size_t n, size_t off)
+{ static const char zeros[8];
+  long at = ftell(f);
+  if (at >= 0 && (size_t) at < off) fwrite(zeros,1,off-at,f);
+  fwrite(p,1,n,f);
+}
+
+void saveCachedTree(const char * dir, unsigned long long hash,
+                    unsigned long long check, long size, CompactTree * tree)
+{ char * name, * temp;
+  NameTable nt;
+  CacheHeader h;
+  size_t off[NSECTIONS];
+  size_t n = tree->nnodes+1;
+  unsigned cap = 16;
+  Attr * attr;
+  FILE * f;
+  NodeId t;
+  int fd, i;
+  while (cap < 2*n) cap *= 2;
+  nt.key = (char **) calloc(cap,sizeof(char *));
+  nt.index = (int *) malloc(cap*sizeof(int));
+  nt.names = (char **) malloc(n*sizeof(char *));
+  attr = (Attr *) calloc(n,sizeof(Attr));
+  if (nt.key == NULL || nt.index == NULL || nt.names == NULL || attr == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  nt.mask = cap-1;
+  nt.nnames = 0;
+  nt.nameBytes = 0;
+  for (t=1;t<n;t++)
+    if (!hasName(tree,t)) attr[t].val = tree->attr[t].val;
+    else if (tree->attr[t].name != NULL)
+      attr[t].val = nameIndex(&nt,tree->attr[t].name);
+
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,MAGIC,sizeof(h.magic));
+  h.hash = hash;
+  h.check = check;
+  h.sourceSize = size;
+  h.nnodes = tree->nnodes;
+  h.root = tree->root;
+  h.nnames = nt.nnames;
+  h.nameBytes = nt.nameBytes;
+  layout(tree->nnodes,nt.nameBytes,off);
+
+  /* written under a temporary name and renamed, so
+   * that a compile running at the same time sees
+   * either the whole file or none
+   */
+  name = cacheFile(dir,hash,"");
+  temp = cacheFile(dir,hash,".XXXXXX");
+  fd = mkstemp(temp);
+  f = fd < 0 ? NULL : fdopen(fd,"w");
+  if (f != NULL)
+  { fwrite(&h,sizeof(h),1,f);
+    writeSection(f,tree->nodekind,n,off[NODEKIND]);
+    writeSection(f,tree->kind,n,off[KIND]);
+    writeSection(f,tree->type,n,off[TYPE]);
+    writeSection(f,tree->child,n*sizeof(*tree->child),off[CHILD]);
+    writeSection(f,tree->sibling,n*sizeof(NodeId),off[SIBLING]);
+    writeSection(f,tree->lineno,n*sizeof(int),off[LINENO]);
+    writeSection(f,tree->size,n*sizeof(int),off[SIZE]);
+    writeSection(f,attr,n*sizeof(Attr),off[ATTR]);
+    writeSection(f,"",0,off[NAMES]);
+    for (i=0;i<nt.nnames;i++)
+      fwrite(nt.names[i],1,strlen(nt.names[i])+1,f);
+    if (fclose(f) != 0 || rename(temp,name) != 0) unlink(temp);
+  }
+  else if (fd >= 0)
+  { close(fd);
+    unlink(temp);
+  }
+  free(name);
+  free(temp);
+  free(nt.key);
+  free(nt.index);
+  free(nt.names);
+  free(attr);
+}
@@ -0,0 +1,44 @@
+/****************************************************/
+/* File: astcache.h                                 */
+/* On-disk cache of syntax trees for the C-         */
+/* compiler: the compact tree of a source that      */
+/* parsed without errors is written to a file named */
+/* by a hash of the source text, and a later        */
+/* compile of the same text maps that file instead  */
+/* of scanning and parsing                          */
+/****************************************************/
+
+#ifndef _ASTCACHE_H_
+#define _ASTCACHE_H_
+
+/* Function sourceHash returns the 64-bit hash of the
+ * size bytes of source text at s that keys the cache,
+ * and sets *check to a second one, computed apart
+ * from it, that a cached tree must match as well
+ */
+unsigned long long sourceHash(const char * s, long size,
+                              unsigned long long * check);
+
+/* Function loadCachedTree returns the tree cached in
+ * directory dir for a source of size bytes with the
+ * given hash and check, mapped rather than read, or
+ * NULL if there is none or it does not fit the
+ * source; its names are interned (see intern.h).
+ * The source text itself is not kept, so a different
+ * text of the same size whose two hashes both collide
+ * would get the wrong tree: a chance of about one in
+ * 2^128 for a given pair of texts
+ */
+CompactTree * loadCachedTree(const char * dir, unsigned long long hash,
+                             unsigned long long check, long size);
+
+/* Procedure saveCachedTree writes tree, which must
+ * not have been type checked yet, to directory dir
+ * as the tree of the source of size bytes with the
+ * given hash and check; a cache that cannot be
+ * written is passed over silently
+ */
+void saveCachedTree(const char * dir, unsigned long long hash,
+                    unsigned long long check, long size, CompactTree * tree);
+
+#endif
@@ -0,0 +1,27 @@
+#!/bin/sh
+# alloc.sh [N [cminus ...]]: builds the allocation counter and prints,
+# for each compiler given (default ./cminus), the malloc calls, peak RSS
+# and run time of a full compile of a 410 KB program of 85 functions
+# and a 650 KB function of 50000 statements, best of N runs (default 5)
+# by time. Give a build from before the arenas as well to compare; it
+# cannot take many more functions, as its scope arrays were fixed. Run
+# from semantic/ after a make clean, so that every object is built with
+# CFLAGS (default -O2).
+n=${1:-5}
+[ $# -gt 0 ] && shift
+[ $# -eq 0 ] && set ./cminus
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" cminus mcount.so >/dev/null || exit 1
+for size in 85 50000; do
+  if [ $size -lt 1000 ]; then python3 ../scanner/bench/gen.py $size 40
+  else python3 bench/listgen.py $size stmts
+  fi > $dir/alloc.cm
+  for cc in "$@"; do
+    i=0
+    while [ $i -lt $n ]; do
+      LD_PRELOAD=./mcount.so $cc $dir/alloc.cm 2>&1 >/dev/null | tail -1
+      i=$((i+1))
+    done | sort -t, -k3 -n | head -1 | sed "s|^|$(wc -c < $dir/alloc.cm) bytes, $cc: |"
+  done
+done
+rm -f $dir/alloc.cm
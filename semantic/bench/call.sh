@@ -0,0 +1,15 @@
+#!/bin/sh
+# call.sh [N]: builds the call checking benchmark and prints the best
+# of N runs (default 25) of typeCheck on programs of 40000 calls to 20
+# callees of 4 parameters, 50 of 16 and 100 of 32. Run from semantic/
+# after a make clean, so that every object is built with CFLAGS
+# (default -O2).
+n=${1:-25}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" callbench >/dev/null || exit 1
+for shape in "20 4" "50 16" "100 32"; do
+  python3 bench/callgen.py 1 $shape 40 1000 > $dir/call.cm
+  set $shape
+  echo "$1 callees x $2 parameters: $(./callbench $dir/call.cm $n)"
+done
+rm -f $dir/call.cm
@@ -0,0 +1,71 @@
+/****************************************************/
+/* File: callbench.c                                */
+/* Call checking benchmark: times typeCheck alone,  */
+/* in its own walk, on a call-dense program         */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../parse.h"
+#include "../compact.h"
+#include "../analyze.h"
+
+FILE * source;
+FILE * listing;
+FILE * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 1;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = FALSE;
+int KeepAnalysis = FALSE;
+
+int Error = FALSE;
+
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+int main(int argc, char * argv[])
+{ int n = argc > 2 ? atoi(argv[2]) : 25;
+  Compilation * c;
+  CompactTree * tree;
+  double least = 0, t;
+  int i;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename> [runs]\n",argv[0]);
+    exit(1);
+  }
+  source = fopen(argv[1],"r");
+  if (source == NULL)
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  /* the symbol table listing is not timed */
+  listing = fopen("/dev/null","w");
+  c = newCompilation(source);
+  tree = compactTree(parseSource(c));
+  if (c->Error) exit(1);
+  for (i=0;i<n;i++)
+  { buildSymtab(tree);
+    t = seconds();
+    typeCheck(tree);
+    t = seconds() - t;
+    if (i == 0 || t < least) least = t;
+  }
+  printf("typeCheck %.2f ms\n",least*1000);
+  return 0;
+}
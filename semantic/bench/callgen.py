@@ -0,0 +1,26 @@
+#!/usr/bin/env python3
+"""Generate a call-dense C- program: callgen.py SEED CALLEES PARAMS CALLERS CALLS
+makes CALLEES functions of PARAMS int or int[] parameters each, and
+CALLERS functions of CALLS well-typed calls to them each"""
+import random, sys
+seed, ncallees, nparams, ncallers, ncalls = map(int, sys.argv[1:6])
+R = random.Random(seed)
+def name(prefix, i):
+    s = ''
+    while True:
+        s = chr(97 + i % 26) + s; i //= 26
+        if i == 0: return prefix + s
+w = sys.stdout.write
+arrays = []
+for i in range(ncallees):
+    a = [R.random() < 0.5 for j in range(nparams)]
+    arrays.append(a)
+    params = ', '.join('int %s%s' % (name('p', j), '[]' if a[j] else '') for j in range(nparams))
+    w('int %s(%s) { return pa%s; }\n' % (name('w', i), params, '[0]' if a[0] else ''))
+for c in range(ncallers):
+    w('void %s(void)\n{ int x; int a[4];\n' % name('c', c))
+    for k in range(ncalls):
+        i = R.randrange(ncallees)
+        w('  x = %s(%s);\n' % (name('w', i), ', '.join('a' if t else 'x' for t in arrays[i])))
+    w('}\n')
+w('void main(void) { ca(); }\n')
@@ -0,0 +1,23 @@
+#!/bin/sh
+# compact.sh [N [cminus ...]]: builds the compact tree benchmark and
+# prints, on a 6 MB program of 1300 functions from the scanner's
+# generator, the best of N runs (default 5) of compactTree and of a
+# walk of the pointer tree and of the compact tree, then for each
+# compiler given (default ./cminus) the peak RSS and run time of a
+# full compile of it. Run from semantic/ after a make clean, so that
+# every object is built with CFLAGS (default -O2).
+n=${1:-5}
+[ $# -gt 0 ] && shift
+[ $# -eq 0 ] && set ./cminus
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" cminus compactbench mcount.so >/dev/null || exit 1
+python3 ../scanner/bench/gen.py 1300 40 > $dir/compact.cm
+echo "$(wc -c < $dir/compact.cm) bytes, $(./compactbench $dir/compact.cm $n)"
+for cc in "$@"; do
+  i=0
+  while [ $i -lt $n ]; do
+    LD_PRELOAD=./mcount.so $cc $dir/compact.cm 2>&1 >/dev/null | tail -1
+    i=$((i+1))
+  done | sort -t, -k3 -n | head -1 | sed "s|^|$cc: |"
+done
+rm -f $dir/compact.cm
@@ -0,0 +1,125 @@
+/****************************************************/
+/* File: compactbench.c                             */
+/* Compact tree benchmark: what flattening the      */
+/* pointer tree costs against what a walk of the    */
+/* compact tree saves                               */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../parse.h"
+#include "../compact.h"
+
+FILE * source;
+FILE * listing;
+FILE * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 1;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = TRUE;
+int KeepAnalysis = FALSE;
+
+int Error = FALSE;
+
+/* what the walks read of each node, so that they
+ * are not optimized away
+ */
+static long seen;
+
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* pointerWalk visits t and its subtrees in
+ * preorder, reading each node's kinds
+ */
+static void pointerWalk(TreeNode * t)
+{ static TreeNode ** stack = NULL;
+  static int cap = 0;
+  int top = 0, i;
+  if (t == NULL) return;
+  if (cap == 0)
+  { cap = 1024;
+    stack = (TreeNode **) malloc(cap*sizeof(TreeNode *));
+  }
+  stack[top++] = t;
+  while (top > 0)
+    for (t = stack[--top]; t != NULL; t = t->sibling)
+    { seen += t->nodekind + t->kind.exp;
+      for (i=MAXCHILDREN-1;i>=0;i--)
+        if (t->child[i] != NULL)
+        { if (top == cap)
+          { cap *= 2;
+            stack = (TreeNode **) realloc(stack,cap*sizeof(TreeNode *));
+          }
+          if (stack == NULL)
+          { fprintf(stderr,"Out of memory error\n");
+            exit(1);
+          }
+          stack[top++] = t->child[i];
+        }
+    }
+}
+
+static void visit(NodeId t, void * arg)
+{ CompactTree * tree = (CompactTree *) arg;
+  seen += tree->nodekind[t] + tree->kind[t];
+}
+
+int main(int argc, char * argv[])
+{ int n = argc > 2 ? atoi(argv[2]) : 7, i;
+  double flat = 0, pointer = 0, compact = 0, t;
+  Compilation * c;
+  TreeNode * syntaxTree;
+  CompactTree * tree = NULL;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename> [runs]\n",argv[0]);
+    exit(1);
+  }
+  source = fopen(argv[1],"r");
+  if (source == NULL)
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  listing = stderr;
+  c = newCompilation(source);
+  syntaxTree = parseSource(c);
+  if (c->Error) exit(1);
+  for (i=0;i<n;i++)
+  { freeCompactTree(tree);
+    t = seconds();
+    tree = compactTree(syntaxTree);
+    t = seconds() - t;
+    if (i == 0 || t < flat) flat = t;
+    t = seconds();
+    pointerWalk(syntaxTree);
+    t = seconds() - t;
+    if (i == 0 || t < pointer) pointer = t;
+    t = seconds();
+    walkTree(tree,tree->root,visit,NULL,tree);
+    t = seconds() - t;
+    if (i == 0 || t < compact) compact = t;
+  }
+  printf("%d nodes, %zu bytes/node as pointers, %zu compact; compactTree %.2f ms;"
+         " a walk %.2f ms over pointers, %.2f ms compact\n",
+         tree->nnodes,sizeof(TreeNode),
+         3+sizeof(*tree->child)+sizeof(NodeId)+sizeof(Attr)+2*sizeof(int)+
+         sizeof(struct ScopeListRec *)+sizeof(Binding),
+         flat*1000,pointer*1000,compact*1000);
+  if (seen == 0) exit(1); /* every walk read something */
+  return 0;
+}
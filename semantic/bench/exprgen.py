@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+"""Generate a C- program of expression statements: exprgen.py SEED N M [P]
+makes N functions of M assignments of random nested expressions over
+locals, parameters and an array, breaking lines between tokens with
+probability P (default 0.3)"""
+import random, sys
+R = random.Random(int(sys.argv[1])); nf = int(sys.argv[2]); ns = int(sys.argv[3])
+nl = float(sys.argv[4]) if len(sys.argv) > 4 else 0.3
+def sp(): return '\n' if R.random() < nl else ' '
+def expr(d):
+    r = R.random()
+    if d > 5 or r < 0.3:
+        k = R.randrange(3)
+        if k == 0: return str(R.randrange(100))
+        if k == 1: return R.choice(['a', 'b', 'x', 'y'])
+        return 'arr[' + sp() + expr(d+1) + sp() + ']'
+    if r < 0.4: return '(' + sp() + expr(d+1) + sp() + ')'
+    op = R.choice(['+', '-', '*', '/', '+', '-', '*', '/', '<', '<=', '>', '>=', '==', '!='])
+    l, r = expr(d+1), expr(d+1)
+    if op in ('<', '<=', '>', '>=', '==', '!='):
+        return '(' + l + sp() + op + sp() + r + ')'
+    return l + sp() + op + sp() + r
+w = sys.stdout.write
+w('int f(int a, int b) { return a; }\n')
+for i in range(nf):
+    w('int f%s(int a, int b)\n{ int x; int y; int arr[10];\n' % ''.join(chr(97+int(c)) for c in str(i)))
+    for j in range(ns):
+        w('  x = ' + expr(0) + ';\n')
+        if R.random() < 0.2: w('  y =' + sp() + 'x =' + sp() + expr(0) + ';\n')
+    w('  return x; }\n')
+w('void main(void) { }\n')
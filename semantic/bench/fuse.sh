@@ -0,0 +1,16 @@
+#!/bin/sh
+# fuse.sh [N]: builds the analysis benchmark and prints the best of N
+# runs (default 7) of buildSymtab and typeCheck, in two walks and
+# fused, on a 7 MB program of 900 functions of nested expressions and
+# a 410 KB program from the scanner's generator. Run from semantic/
+# after a make clean, so that every object is built with CFLAGS
+# (default -O2).
+n=${1:-7}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" fusebench >/dev/null || exit 1
+python3 bench/exprgen.py 20 900 60 > $dir/fuse1.cm
+python3 ../scanner/bench/gen.py 85 40 > $dir/fuse2.cm
+for f in $dir/fuse1.cm $dir/fuse2.cm; do
+  echo "$(wc -c < $f) bytes, $(./fusebench $f $n)"
+done
+rm -f $dir/fuse1.cm $dir/fuse2.cm
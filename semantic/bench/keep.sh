@@ -0,0 +1,13 @@
+#!/bin/sh
+# keep.sh [N]: builds the incremental analysis benchmark and prints the
+# best of N runs (default 7) of a full analysis of a 7 MB program of
+# 900 functions against one that keeps every body from the analysis
+# before, as an edit session does when no body changed. Run from
+# semantic/ after a make clean, so that every object is built with
+# CFLAGS (default -O2).
+n=${1:-7}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" keepbench >/dev/null || exit 1
+python3 bench/exprgen.py 20 900 60 > $dir/keep.cm
+echo "$(wc -c < $dir/keep.cm) bytes: $(./keepbench $dir/keep.cm $n)"
+rm -f $dir/keep.cm
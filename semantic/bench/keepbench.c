@@ -0,0 +1,87 @@
+/****************************************************/
+/* File: keepbench.c                                */
+/* Incremental analysis benchmark: times a full     */
+/* analysis against one that keeps every body from  */
+/* the analysis before                              */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../parse.h"
+#include "../compact.h"
+#include "../analyze.h"
+
+FILE * source;
+FILE * listing;
+FILE * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 1;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = TRUE;
+int KeepAnalysis = FALSE;
+
+int Error = FALSE;
+
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* analyze returns how long buildSymtab and
+ * typeCheck take on tree
+ */
+static double analyze(CompactTree * tree)
+{ double t = seconds();
+  buildSymtab(tree);
+  typeCheck(tree);
+  return seconds() - t;
+}
+
+int main(int argc, char * argv[])
+{ int n = argc > 2 ? atoi(argv[2]) : 7;
+  Compilation * c;
+  CompactTree * tree;
+  double full = 0, kept = 0, t;
+  int i, checked, bodies;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename> [runs]\n",argv[0]);
+    exit(1);
+  }
+  source = fopen(argv[1],"r");
+  if (source == NULL)
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  /* the symbol table listing is not timed */
+  listing = fopen("/dev/null","w");
+  c = newCompilation(source);
+  tree = compactTree(parseSource(c));
+  if (c->Error) exit(1);
+  for (i=0;i<n;i++)
+  { KeepAnalysis = FALSE;
+    t = analyze(tree);
+    if (i == 0 || t < full) full = t;
+    /* the first keeps the bodies for the second */
+    KeepAnalysis = TRUE;
+    analyze(tree);
+    t = analyze(tree);
+    if (i == 0 || t < kept) kept = t;
+  }
+  checked = bodiesChecked(&bodies);
+  printf("full %.2f ms, %d of %d bodies analyzed %.2f ms\n",
+         full*1000,checked,bodies,kept*1000);
+  return 0;
+}
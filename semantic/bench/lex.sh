@@ -0,0 +1,16 @@
+#!/bin/sh
+# lex.sh [N [T]]: builds the lexer benchmark and prints the best of N
+# runs (default 3) of pulling tokens through getToken against scanning
+# the whole source into the token buffer, then of the parses that read
+# them each way, then of the parallel lexer on 2, 4, ... up to T threads
+# (default one per processor). Run from semantic/ after a make clean,
+# so that every object is built with CFLAGS (default -O2).
+n=${1:-3}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" lexbench >/dev/null || exit 1
+for size in 100000 1000000; do
+  python3 bench/listgen.py $size stmts > $dir/lexbench.cm
+  echo "$size stmts:"
+  ./lexbench $dir/lexbench.cm $n $2
+done
+rm -f $dir/lexbench.cm
@@ -0,0 +1,109 @@
+/****************************************************/
+/* File: lexbench.c                                 */
+/* Lexer benchmark: times pulling tokens one at a   */
+/* time against scanning them all into the token    */
+/* buffer, alone and with the parse that follows,   */
+/* and the parallel lexer on ever more threads      */
+/****************************************************/
+
+#include <time.h>
+#include <unistd.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../parse.h"
+#include "../tokbuf.h"
+
+FILE * source;
+FILE * listing;
+FILE * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 1;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = TRUE;
+int KeepAnalysis = FALSE;
+
+int Error = FALSE;
+
+/* the ways of going through the source */
+typedef enum {PULL, SCAN, PARSE} Mode;
+
+static long ntokens;
+
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* best returns the least time of n runs over the
+ * file in mode m: pulling every token through
+ * getToken, scanning them all into the token
+ * buffer, or parsing with BufferTokens as it is
+ */
+static double best(char * name, Mode m, int n)
+{ double least = 0;
+  int i;
+  for (i=0;i<n;i++)
+  { Compilation * c;
+    double t;
+    source = fopen(name,"r");
+    if (source == NULL)
+    { fprintf(stderr,"File %s not found\n",name);
+      exit(1);
+    }
+    c = newCompilation(source);
+    holdSource(c); /* mapping the file is not lexing */
+    t = seconds();
+    if (m == PULL)
+      for (ntokens=1; getToken(c) != ENDFILE; ntokens++);
+    else if (m == SCAN)
+    { scanTokens(c);
+      ntokens = c->tokens->ntokens;
+    }
+    else parseSource(c);
+    t = seconds() - t;
+    if (Error) exit(1);
+    freeCompilation(c);
+    fclose(source);
+    if (i == 0 || t < least) least = t;
+  }
+  return least;
+}
+
+int main(int argc, char * argv[])
+{ int n = argc > 2 ? atoi(argv[2]) : 3;
+  int most = argc > 3 ? atoi(argv[3]) : sysconf(_SC_NPROCESSORS_ONLN);
+  double t, one;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename> [runs] [threads]\n",argv[0]);
+    exit(1);
+  }
+  listing = stderr;
+  t = best(argv[1],PULL,n);
+  printf("%ld tokens: getToken %.3f s (%.1f Mtokens/s)",ntokens,t,ntokens/t/1e6);
+  t = best(argv[1],SCAN,n);
+  printf(", scanTokens %.3f s (%.1f Mtokens/s)\n",t,ntokens/t/1e6);
+  BufferTokens = FALSE;
+  printf("parse pulling tokens %.3f s",best(argv[1],PARSE,n));
+  BufferTokens = TRUE;
+  printf(", from the token buffer %.3f s\n",best(argv[1],PARSE,n));
+  /* then scanTokens on 1, 2, 4, ... up to most threads */
+  one = best(argv[1],SCAN,n);
+  for (ScanThreads=2; ScanThreads<2*most && ScanThreads<=MAXTHREADS; ScanThreads*=2)
+  { if (ScanThreads > most) ScanThreads = most;
+    t = best(argv[1],SCAN,n);
+    printf("scanTokens on %d threads %.3f s, %.2fx one thread\n",ScanThreads,t,one/t);
+  }
+  return 0;
+}
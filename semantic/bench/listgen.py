@@ -0,0 +1,18 @@
+#!/usr/bin/env python3
+"""Generate a C- program with one long list: listgen.py N stmts|decls
+stmts puts N statements in one function, decls makes N global declarations"""
+import sys
+n = int(sys.argv[1]); kind = sys.argv[2]
+w = sys.stdout.write
+if kind == 'stmts':
+    w('void main(void)\n{ int x;\n  x = 0;\n')
+    for i in range(n): w('  x = x + 1;\n')
+    w('}\n')
+else:
+    def name(i):
+        s = ''
+        while True:
+            s += chr(97 + i % 26); i //= 26
+            if i == 0: return 'g' + s
+    for i in range(n): w('int %s;\n' % name(i))
+    w('void main(void) { }\n')
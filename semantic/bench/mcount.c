@@ -0,0 +1,48 @@
+/****************************************************/
+/* File: mcount.c                                   */
+/* Allocation counter for the arena benchmark: an   */
+/* LD_PRELOAD library that counts malloc, calloc    */
+/* and realloc calls and reports them, the peak RSS */
+/* and the run time to stderr at exit               */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/* the allocator of the C library under these */
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t n, size_t size);
+extern void * __libc_realloc(void * p, size_t size);
+
+static long calls;
+static struct timespec start;
+
+void * malloc(size_t size)
+{ calls++;
+  return __libc_malloc(size);
+}
+
+void * calloc(size_t n, size_t size)
+{ calls++;
+  return __libc_calloc(n,size);
+}
+
+void * realloc(void * p, size_t size)
+{ calls++;
+  return __libc_realloc(p,size);
+}
+
+__attribute__((constructor)) static void begin(void)
+{ clock_gettime(CLOCK_MONOTONIC,&start);
+}
+
+__attribute__((destructor)) static void report(void)
+{ struct rusage r;
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC,&end);
+  getrusage(RUSAGE_SELF,&r);
+  fprintf(stderr,"%ld mallocs, peak RSS %ld KB, %.1f ms\n",calls,r.ru_maxrss,
+          (end.tv_sec-start.tv_sec)*1e3 + (end.tv_nsec-start.tv_nsec)/1e6);
+}
@@ -0,0 +1,78 @@
+/****************************************************/
+/* File: parsebench.c                               */
+/* Parser benchmark: times parseSource on a file    */
+/* with the yacc and the recursive-descent parser   */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../parse.h"
+
+FILE * source;
+FILE * listing;
+FILE * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 0;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = TRUE;
+int KeepAnalysis = FALSE;
+
+int Error = FALSE;
+
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* best returns the least time of n parses of the
+ * file with the parser YaccParse selects
+ */
+static double best(char * name, int n)
+{ double least = 0;
+  int i;
+  for (i=0;i<n;i++)
+  { Compilation * c;
+    double t;
+    source = fopen(name,"r");
+    if (source == NULL)
+    { fprintf(stderr,"File %s not found\n",name);
+      exit(1);
+    }
+    c = newCompilation(source);
+    t = seconds();
+    parseSource(c);
+    t = seconds() - t;
+    if (Error) exit(1);
+    freeCompilation(c);
+    fclose(source);
+    if (i == 0 || t < least) least = t;
+  }
+  return least;
+}
+
+int main(int argc, char * argv[])
+{ int n = argc > 2 ? atoi(argv[2]) : 3;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename> [runs]\n",argv[0]);
+    exit(1);
+  }
+  listing = stderr;
+  YaccParse = TRUE;
+  printf("yacc %.3f s",best(argv[1],n));
+  YaccParse = FALSE;
+  printf(", recursive descent %.3f s\n",best(argv[1],n));
+  return 0;
+}
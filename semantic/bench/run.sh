@@ -0,0 +1,15 @@
+#!/bin/sh
+# run.sh [N]: builds the parser benchmark and prints the best of N
+# parses (default 3) of programs with ever longer lists of statements
+# and of declarations. Run from semantic/ after a make clean, so that
+# every object is built with CFLAGS (default -O2).
+n=${1:-3}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" parsebench >/dev/null || exit 1
+for kind in stmts decls; do
+  for size in 10000 40000 250000 1000000; do
+    python3 bench/listgen.py $size $kind > $dir/parsebench.cm
+    echo "$size $kind: $(./parsebench $dir/parsebench.cm $n)"
+  done
+done
+rm -f $dir/parsebench.cm
@@ -0,0 +1,20 @@
+#!/bin/sh
+# scope.sh [N]: builds the symbol table benchmark and prints the memory
+# of the table and the best of N runs (default 9) of buildSymtab on
+# programs from scopegen.py with 100k block scopes and 100 globals,
+# 100k globals and 2000 blocks, and 100k of both; then the latency of
+# st_insert and st_lookup with 1000 and 100k globals. Run from
+# semantic/ after a make clean, so that every object is built with
+# CFLAGS (default -O2).
+n=${1:-9}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" scopebench >/dev/null || exit 1
+for shape in "100 100 1000" "100000 2 1000" "100000 100 1000"; do
+  python3 bench/scopegen.py 1 $shape 2 > $dir/scope.cm
+  set $shape
+  echo "$1 globals, $(($2*$3)) blocks: $(./scopebench $dir/scope.cm $n)"
+done
+rm -f $dir/scope.cm
+for globals in 1000 100000; do
+  echo "$globals globals: $(./scopebench -l $globals)"
+done
@@ -0,0 +1,155 @@
+/****************************************************/
+/* File: scopebench.c                               */
+/* Symbol table benchmark: the memory and time      */
+/* buildSymtab takes on a program, or the latency   */
+/* of st_insert and st_lookup with many globals     */
+/****************************************************/
+
+#include <time.h>
+#include <malloc.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../parse.h"
+#include "../compact.h"
+#include "../analyze.h"
+#include "../symtab.h"
+#include "../intern.h"
+
+FILE * source;
+FILE * listing;
+FILE * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 1;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = FALSE;
+int KeepAnalysis = FALSE;
+
+int Error = FALSE;
+
+/* lookups timed for each latency */
+#define LOOKUPS 2000000
+
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* tableSize prints the bytes of the symbol table
+ * buildSymtab makes for the file and the least time
+ * of n runs of it
+ */
+static void tableSize(char * name, int n)
+{ Compilation * c;
+  CompactTree * tree;
+  size_t before, after;
+  double least = 0, t;
+  int i;
+  source = fopen(name,"r");
+  if (source == NULL)
+  { fprintf(stderr,"File %s not found\n",name);
+    exit(1);
+  }
+  c = newCompilation(source);
+  tree = compactTree(parseSource(c));
+  if (c->Error) exit(1);
+  buildSymtab(tree);
+  st_reset();
+  before = mallinfo2().uordblks;
+  buildSymtab(tree);
+  after = mallinfo2().uordblks;
+  for (i=0;i<n;i++)
+  { t = seconds();
+    buildSymtab(tree);
+    t = seconds() - t;
+    if (i == 0 || t < least) least = t;
+  }
+  printf("table %zu bytes, scope record %zu bytes, buildSymtab %.2f ms\n",
+         after-before,sizeof(struct ScopeListRec),least*1000);
+}
+
+/* lookups prints the time of each st_insert of
+ * nglobals globals, and of an st_lookup of a random
+ * one of them from a function's scope, from three
+ * blocks inside it, and of a local there
+ */
+static void lookups(int nglobals)
+{ char ** global = (char **) malloc(nglobals*sizeof(char *));
+  char buf[32], * fun, * block, * local;
+  ScopeList scope;
+  unsigned x = 1;
+  double t;
+  long sum = 0;
+  int i, k;
+  if (global == NULL)
+  { fprintf(stderr,"Out of memory error\n");
+    exit(1);
+  }
+  for (i=0;i<nglobals;i++)
+  { sprintf(buf,"g%d",i);
+    global[i] = internString(buf);
+  }
+  fun = internString("f");
+  block = internString(".if");
+  local = internString("l");
+  scope = scope_create(internString("Global"));
+  scope_push(scope);
+  t = seconds();
+  for (i=0;i<nglobals;i++)
+    st_insert(scope->name,global[i],Integer,i,addLocation(),i+1);
+  t = seconds() - t;
+  printf("insert %.1f ns",t*1e9/nglobals);
+  st_insert(scope->name,fun,Void,1,addLocation(),nglobals+1);
+  scope_push(scope_create(fun));
+  t = seconds();
+  for (k=0;k<LOOKUPS;k++)
+  { x = x*1103515245+12345;
+    sum += (long) st_lookup(global[(x>>8)%nglobals]);
+  }
+  t = seconds() - t;
+  printf(", hit in Global %.1f ns",t*1e9/LOOKUPS);
+  for (i=0;i<3;i++)
+    scope_push(scope_create(block));
+  st_insert(block,local,Integer,2,addLocation(),nglobals+2);
+  t = seconds();
+  for (k=0;k<LOOKUPS;k++)
+  { x = x*1103515245+12345;
+    sum += (long) st_lookup(global[(x>>8)%nglobals]);
+  }
+  t = seconds() - t;
+  printf(", from 3 blocks deep %.1f ns",t*1e9/LOOKUPS);
+  t = seconds();
+  for (k=0;k<LOOKUPS;k++)
+    sum += (long) st_lookup(local);
+  t = seconds() - t;
+  printf(", local %.1f ns\n",t*1e9/LOOKUPS);
+  if (sum == 0) exit(1); /* every lookup hit */
+  free(global);
+}
+
+int main(int argc, char * argv[])
+{ if (argc == 3 && strcmp(argv[1],"-l") == 0)
+  { lookups(atoi(argv[2]));
+    return 0;
+  }
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename> [runs]\n",argv[0]);
+    fprintf(stderr,"       %s -l <globals>\n",argv[0]);
+    exit(1);
+  }
+  /* the symbol table listing is not timed */
+  listing = fopen("/dev/null","w");
+  tableSize(argv[1],argc > 2 ? atoi(argv[2]) : 9);
+  return 0;
+}
@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+"""Generate a scope-heavy C- program: scopegen.py SEED GLOBALS FUNCS BLOCKS REFS
+makes GLOBALS global ints and FUNCS functions of BLOCKS block scopes
+each (if, else and while, some nested, most with one local or none),
+every block making REFS references to random globals and its local"""
+import random, sys
+seed, nglobals, nfuncs, nblocks, nrefs = map(int, sys.argv[1:6])
+R = random.Random(seed)
+def name(prefix, i):
+    s = ''
+    while True:
+        s = chr(97 + i % 26) + s; i //= 26
+        if i == 0: return prefix + s
+def refs(local):
+    return ' '.join('x = x + %s;' % (local if local and R.random() < 0.3
+                                     else name('g', R.randrange(nglobals)))
+                    for k in range(nrefs))
+def block(k):
+    local = name('l', k) if R.random() < 0.6 else None
+    return ('int %s; ' % local if local else '') + refs(local)
+w = sys.stdout.write
+for i in range(nglobals): w('int %s;\n' % name('g', i))
+for f in range(nfuncs):
+    w('void %s(void)\n{ int x;\n' % name('f', f))
+    b = 0
+    while b < nblocks:
+        r = R.random()
+        if r < 0.4 and b + 2 <= nblocks:
+            w('  if (x < 3) { %s } else { %s }\n' % (block(b), block(b+1))); b += 2
+        elif r < 0.7:
+            w('  while (x < 9) { %s }\n' % block(b)); b += 1
+        elif b + 2 <= nblocks:
+            w('  if (x) { %s while (x) { %s } }\n' % (block(b), block(b+1))); b += 2
+        else:
+            w('  if (x) { %s }\n' % block(b)); b += 1
+    w('}\n')
+w('void main(void) { fa(); }\n')
@@ -0,0 +1,15 @@
+#!/bin/sh
+# skim.sh [N]: builds the parallel parse benchmark and prints the best
+# of N parses (default 5) of generated programs of about 2 and 6 MB,
+# in order and on 1 to 32 threads after a skim. The programs come from
+# the scanner's generator, ../scanner/bench/gen.py. Run from semantic/
+# after a make clean, so that every object is built with CFLAGS
+# (default -O2).
+n=${1:-5}
+dir=${TMPDIR:-/tmp}
+make CFLAGS="${CFLAGS:--O2}" skimbench >/dev/null || exit 1
+for funcs in 450 1300; do
+  python3 ../scanner/bench/gen.py $funcs 40 > $dir/skimbench.cm
+  echo "$(wc -c < $dir/skimbench.cm) bytes: $(./skimbench $dir/skimbench.cm $n)"
+done
+rm -f $dir/skimbench.cm
@@ -0,0 +1,86 @@
+/****************************************************/
+/* File: skimbench.c                                */
+/* Parallel parse benchmark: times parseParallel    */
+/* on 1 to 32 threads against parseSource           */
+/****************************************************/
+
+#include <time.h>
+#include "../globals.h"
+#include "../scan.h"
+#include "../parse.h"
+#include "../skim.h"
+
+FILE * source;
+FILE * listing;
+FILE * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 1;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = TRUE;
+int KeepAnalysis = FALSE;
+
+int Error = FALSE;
+
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* best returns the least time of n parses of the
+ * file, on nthreads threads after a skim, or with
+ * parseSource if nthreads is 0
+ */
+static double best(char * name, int nthreads, int n)
+{ double least = 0;
+  int i;
+  for (i=0;i<n;i++)
+  { Compilation * c;
+    TreeNode * tree;
+    double t;
+    source = fopen(name,"r");
+    if (source == NULL)
+    { fprintf(stderr,"File %s not found\n",name);
+      exit(1);
+    }
+    c = newCompilation(source);
+    t = seconds();
+    tree = nthreads ? parseParallel(c,nthreads) : parseSource(c);
+    t = seconds() - t;
+    if (tree == NULL || c->Error) exit(1);
+    freeCompilation(c);
+    fclose(source);
+    if (i == 0 || t < least) least = t;
+  }
+  return least;
+}
+
+int main(int argc, char * argv[])
+{ int n = argc > 2 ? atoi(argv[2]) : 5;
+  int nthreads;
+  double seq, t;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename> [runs]\n",argv[0]);
+    exit(1);
+  }
+  listing = stderr;
+  seq = best(argv[1],0,n);
+  printf("sequential %.1f ms",seq*1000);
+  for (nthreads=1;nthreads<=32;nthreads*=2)
+  { t = best(argv[1],nthreads,n);
+    printf(", %d: %.1f ms (%.2fx)",nthreads,t*1000,seq/t);
+  }
+  printf("\n");
+  return 0;
+}
@@ -10,48 +10,76 @@
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "parse.h"
+#include "tokbuf.h"
+#include "plex.h"
+#include "rdparse.h"
+#include "skim.h"
 
 #define YYSTYPE TreeNode *
-static char * savedName; /* for use in assignments */
-static int savedNum;
-static int savedLineNo;  /* ditto */
-static TreeNode * savedTree; /* stores syntax tree for later return */
-static int yylex(void); // added 11/2/11 to ensure no conflict with lex
-
-static TreeNode *l = NULL; /* local dec list */
-static TreeNode *s = NULL; /* stmt list */
-static TreeNode *d = NULL; /* dec list */
-static TreeNode *p = NULL; /* params list */
-static TreeNode *a = NULL; /* argument list */
+/* the parser is pure: what it keeps between tokens
+ * lives in the Compilation c it is called with
+ */
+/* the location of a symbol is just the line where
+ * it starts, so that an operator node can be given
+ * the line of its operator once both operands are in
+ */
+#define YYLLOC_DEFAULT(Current, Rhs, N) \
+  ((Current) = (N) ? YYRHSLOC(Rhs,1) : YYRHSLOC(Rhs,0))
+static int yylex(YYSTYPE * lvalp, int * llocp, Compilation * c);
+static int yyerror(int * llocp, Compilation * c, const char * message);
+static TreeNode * newOpNode(Compilation * c, TokenType op, int lineno, TreeNode * left, TreeNode * right);
+
+/* While a list is built, its value is the last node,
+ * and the sibling of the last node is the first, so
+ * that appending takes constant time; listHead turns
+ * it back into a plain list once it is complete
+ */
+static TreeNode * addToList(TreeNode * last, TreeNode * t);
+static TreeNode * newOpNode(Compilation * c, TokenType op, int lineno, TreeNode * left, TreeNode * right)
+{ TreeNode * t = newExpNode(c->arena,OpK,lineno);
+  t->attr.op = op;
+  t->child[0] = left;
+  t->child[1] = right;
+  return t;
+}
+
+static TreeNode * listHead(TreeNode * last);
 
 %}
 
+%define api.pure full
+%define api.push-pull both
+%define api.location.type {int}
+%locations
+%parse-param {Compilation * c}
+%lex-param {Compilation * c}
+
 %token IF ELSE RETURN WHILE VOID INT
 %token ID NUM
 %token ASSIGN EQ NE LT LE GT GE PLUS MINUS TIMES OVER SEMI COMMA LPAREN RPAREN LBRACE RBRACE LCURLY RCURLY
 %token ERROR 
+%token DECLIST /* only ever sent first by yylex, see parseTokens */
+
+/* binary operators, loosest first; comparisons do
+ * not chain
+ */
+%nonassoc LE LT GT GE EQ NE
+%left PLUS MINUS
+%left TIMES OVER
 
 %% /* Grammar for TINY */
 
 program     : dec_list
-                 { savedTree = $1;} 
+                 { c->savedTree = listHead($1);} 
+            | DECLIST dec_list
+                 { c->savedTree = listHead($2);}
             ;
 
 dec_list    : dec_list dec
-              {
-                d = $1;
-                if(d==NULL){
-                  $$ = $2;
-                }else{
-                  while(d->sibling != NULL){
-                    d = d->sibling;
-                  }
-                  d->sibling = $2;
-                  $$ = $1;
-                }
-              }
+              { $$ = addToList($1,$2); }
               
-            | dec { $$ = $1; }
+            | dec { $$ = addToList(NULL,$1); }
             ;
 
 dec         : var_dec { $$ = $1; }
@@ -60,25 +88,25 @@ dec         : var_dec { $$ = $1; }
 
 id          : ID
               {
-                savedName = copyString(tokenString);
+                c->savedName = c->tokenString; /* interned by the scanner */
               };
 
 
 var_dec     : type_spec id SEMI
               {
                 $$ = $1;
-                $$->attr.name = savedName;
+                $$->attr.name = c->savedName;
               }
             | type_spec id 
               {
                 $$ = $1;
-                $$->attr.name = savedName;
+                $$->attr.name = c->savedName;
                 $$->type = Array;
               }
               LBRACE NUM
               {
                 $$ = $3;
-                $$->size = atoi(tokenString);
+                $$->size = atoi(c->tokenString);
               }
               RBRACE SEMI
               {
@@ -88,12 +116,12 @@ var_dec     : type_spec id SEMI
 
 type_spec   : INT
               {
-                $$ = newDecNode(VarK);
+                $$ = newDecNode(c->arena,VarK,c->lineno);
                 $$->type = Integer;
               }
             | VOID
               {
-                $$ = newDecNode(VarK);
+                $$ = newDecNode(c->arena,VarK,c->lineno);
                 $$->type = Void;
               }
             ;
@@ -102,7 +130,7 @@ fun_dec     : type_spec id
                 {
                   $$ = $1;
                   $$->kind.dec = FunK;
-                  $$->attr.name = savedName;
+                  $$->attr.name = c->savedName;
                 }
               LPAREN params RPAREN comp_stmt
               {
@@ -113,35 +141,24 @@ fun_dec     : type_spec id
               }
             ;
 
-params      : params_list {$$ = $1;}
+params      : params_list {$$ = listHead($1);}
             | VOID
               {
-                $$ = newDecNode(ParamK);
+                $$ = newDecNode(c->arena,ParamK,c->lineno);
                 $$->type = Void;
               }
             ;
 
 params_list : params_list COMMA param
-              {
-                p = $1;
-                if(p==NULL){
-                  $$ = $3;
-                }else{
-                  while(p->sibling != NULL){
-                    p = p->sibling;
-                  }
-                  p->sibling = $3;
-                  $$ = $1;
-                }
-              }
-            | param { $$ = $1; }
+              { $$ = addToList($1,$3); }
+            | param { $$ = addToList(NULL,$1); }
             ;
 
 param       : type_spec id
               {
                 $$ = $1;
                 $$->kind.dec = ParamK;
-                $$->attr.name = savedName;
+                $$->attr.name = c->savedName;
               }
             | type_spec id LBRACE RBRACE
               {
@@ -149,47 +166,25 @@ param       : type_spec id
                 $$->kind.dec = ParamK;
                 $$->type = Array;
                 $$->size = 0;
-                $$->attr.name = savedName;
+                $$->attr.name = c->savedName;
               }
             ;
 
 comp_stmt   : LCURLY local_dec stmt_list RCURLY
               {
-                $$ = newStmtNode(CompK);
-                $$->child[0] = $2;
-                $$->child[1] = $3;
+                $$ = newStmtNode(c->arena,CompK,c->lineno);
+                $$->child[0] = listHead($2);
+                $$->child[1] = listHead($3);
               }
             ;
 
 local_dec   : local_dec var_dec
-              {
-                l = $1;
-                if(l==NULL){
-                  $$ = $2;
-                }else{
-                  while(l->sibling != NULL){
-                    l = l->sibling;
-                  }
-                  l->sibling = $2;
-                  $$ = $1;
-                }
-              }
+              { $$ = addToList($1,$2); }
             | { $$ = NULL; }
             ;
 
 stmt_list   : stmt_list stmt
-              {
-                s = $1;
-                if(s==NULL){
-                  $$ = $2;
-                }else{
-                  while(s->sibling != NULL){
-                    s = s->sibling;
-                  }
-                  s->sibling = $2;
-                  $$ = $1;
-                }
-              }
+              { $$ = addToList($1,$2); }
             | { $$ = NULL; }
             ;
 
@@ -205,13 +200,13 @@ exp_stmt    : exp SEMI {$$ = $1;}
             ;
 
 select_stmt : IF LPAREN exp RPAREN stmt
-                { $$ = newStmtNode(IfK);
+                { $$ = newStmtNode(c->arena,IfK,c->lineno);
                   $$->child[0] = $3;
                   $$->child[1] = $5;
                   $$->child[2] = NULL;
                 }
             | IF LPAREN exp RPAREN stmt ELSE stmt
-                { $$ = newStmtNode(IfK);
+                { $$ = newStmtNode(c->arena,IfK,c->lineno);
                   $$->child[0] = $3;
                   $$->child[1] = $5;
                   $$->child[2] = $7;
@@ -220,7 +215,7 @@ select_stmt : IF LPAREN exp RPAREN stmt
 
 iter_stmt   : WHILE LPAREN exp RPAREN stmt
               {
-                $$ = newStmtNode(WhileK);
+                $$ = newStmtNode(c->arena,WhileK,c->lineno);
                 $$->child[0] = $3;
                 $$->child[1] = $5;
               }
@@ -228,18 +223,18 @@ iter_stmt   : WHILE LPAREN exp RPAREN stmt
 
 return_stmt : RETURN SEMI
               {
-                $$ = newStmtNode(RetK);
+                $$ = newStmtNode(c->arena,RetK,c->lineno);
               }
             | RETURN exp SEMI
               {
-                $$ = newStmtNode(RetK);
+                $$ = newStmtNode(c->arena,RetK,c->lineno);
                 $$->child[0] = $2;
               }
             ;
 
 exp         : var ASSIGN exp
               {
-                $$ = newExpNode(OpK);
+                $$ = newExpNode(c->arena,OpK,c->lineno);
                 $$->attr.op = ASSIGN;
                 $$->child[0] = $1;
                 $$->child[1] = $3;
@@ -249,13 +244,13 @@ exp         : var ASSIGN exp
 
 var         : id
               {
-                $$ = newExpNode(IdK);
-                $$->attr.name = savedName;
+                $$ = newExpNode(c->arena,IdK,c->lineno);
+                $$->attr.name = c->savedName;
               }
             | id 
               {
-                $$ = newExpNode(ArrIdK);
-                $$->attr.name = savedName;
+                $$ = newExpNode(c->arena,ArrIdK,c->lineno);
+                $$->attr.name = c->savedName;
               }
               LBRACE exp RBRACE
               {
@@ -264,80 +259,31 @@ var         : id
               }
             ;
 
-simple_exp  : add_exp relop add_exp
-              {
-                $$ = $2;
-                $$->child[0] = $1;
-                $$->child[1] = $3;
-              }
-            | add_exp {$$ = $1;}
-            ;
-
-relop       : LE {
-                $$ = newExpNode(OpK);
-                $$->attr.op = LE;
-              }
-              | LT {
-                $$ = newExpNode(OpK);
-                $$->attr.op = LT;
-              }
-              | GT {
-                $$ = newExpNode(OpK);
-                $$->attr.op = GT;
-              }
-              | GE {
-                $$ = newExpNode(OpK);
-                $$->attr.op = GE;
-              }
-              | EQ {
-                $$ = newExpNode(OpK);
-                $$->attr.op = EQ;
-              }
-              | NE {
-                $$ = newExpNode(OpK);
-                $$->attr.op = NE;
-              }
-            ;
-
-add_exp     : add_exp addop term
-              {
-                $$ = $2;
-                $$->child[0] = $1;
-                $$->child[1] = $3;
-              }
-            | term {$$ = $1;}
-            ;
-
-addop       : PLUS {
-                $$ = newExpNode(OpK); 
-                $$->attr.op = PLUS;
-              }
-              | MINUS {
-                $$ = newExpNode(OpK);
-                $$->attr.op = MINUS;
-              }
-            ;
-
-term        : term mulop factor
-              {
-                $$ = $2;
-                $$->child[0] = $1;
-                $$->child[1] = $3;
-              }
-            | factor {$$ = $1;}
-            ;
-
-mulop       : TIMES {
-                $$ = newExpNode(OpK); 
-                $$->attr.op = TIMES;
-              }
-              | OVER {
-                $$ = newExpNode(OpK);
-                $$->attr.op = OVER;
-              }
-            ;
-
-factor      : LPAREN exp RPAREN
+/* the operands of a binary operator are simple
+ * expressions too, with the precedence declarations
+ * above standing in for a rule per level
+ */
+simple_exp  : simple_exp LE simple_exp
+              { $$ = newOpNode(c,LE,@2,$1,$3); }
+            | simple_exp LT simple_exp
+              { $$ = newOpNode(c,LT,@2,$1,$3); }
+            | simple_exp GT simple_exp
+              { $$ = newOpNode(c,GT,@2,$1,$3); }
+            | simple_exp GE simple_exp
+              { $$ = newOpNode(c,GE,@2,$1,$3); }
+            | simple_exp EQ simple_exp
+              { $$ = newOpNode(c,EQ,@2,$1,$3); }
+            | simple_exp NE simple_exp
+              { $$ = newOpNode(c,NE,@2,$1,$3); }
+            | simple_exp PLUS simple_exp
+              { $$ = newOpNode(c,PLUS,@2,$1,$3); }
+            | simple_exp MINUS simple_exp
+              { $$ = newOpNode(c,MINUS,@2,$1,$3); }
+            | simple_exp TIMES simple_exp
+              { $$ = newOpNode(c,TIMES,@2,$1,$3); }
+            | simple_exp OVER simple_exp
+              { $$ = newOpNode(c,OVER,@2,$1,$3); }
+            | LPAREN exp RPAREN
               {
                 $$ = $2;
               }
@@ -351,15 +297,15 @@ factor      : LPAREN exp RPAREN
               }
             | NUM
               {
-                $$ = newExpNode(ConstK);
-                $$->attr.val = atoi(tokenString);
+                $$ = newExpNode(c->arena,ConstK,c->lineno);
+                $$->attr.val = atoi(c->tokenString);
               }
             ;
 
 call        : id 
                 {
-                  $$ = newExpNode(CallK);
-                  $$->attr.name = savedName;  
+                  $$ = newExpNode(c->arena,CallK,c->lineno);
+                  $$->attr.name = c->savedName;  
                 }
               LPAREN args RPAREN
               {
@@ -368,45 +314,156 @@ call        : id
               }
             ;
 
-args        : arg_list {$$ = $1;}
+args        : arg_list {$$ = listHead($1);}
             | { $$ = NULL; }
             ;
 
 arg_list    : arg_list COMMA exp
-              {
-                a = $1;
-                if(a==NULL){
-                  $$ = $3;
-                }else{
-                  while(a->sibling != NULL){
-                    a = a->sibling;
-                  }
-                  a->sibling = $3;
-                  $$ = $1;
-                }
-              }
-            | exp {$$ = $1;}
+              { $$ = addToList($1,$3); }
+            | exp {$$ = addToList(NULL,$1);}
 
 
 %%
 
-int yyerror(char * message)
-{ fprintf(listing,"Syntax error at line %d: %s\n",lineno,message);
-  fprintf(listing,"Current token: ");
-  printToken(yychar,tokenString);
-  Error = TRUE;
+static int yyerror(int * llocp, Compilation * c, const char * message)
+{ (void) llocp; /* the line is c->lineno */
+  if (c->quiet) return 0;
+  /* keep the lines together when several sources
+   * are parsed at once
+   */
+  flockfile(c->listing);
+  fprintf(c->listing,"Syntax error at line %d: %s\n",c->lineno,message);
+  fprintf(c->listing,"Current token: ");
+  fprintToken(c->listing,c->token,c->tokenString);
+  funlockfile(c->listing);
+  c->Error = TRUE;
   return 0;
 }
 
+static TreeNode * addToList(TreeNode * last, TreeNode * t)
+{ if (t == NULL) return last;
+  if (last == NULL) t->sibling = t;
+  else
+  { t->sibling = last->sibling;
+    last->sibling = t;
+  }
+  return t;
+}
+
+static TreeNode * listHead(TreeNode * last)
+{ TreeNode * first;
+  if (last == NULL) return NULL;
+  first = last->sibling;
+  last->sibling = NULL;
+  return first;
+}
+
 /* yylex calls getToken to make Yacc/Bison output
- * compatible with ealier versions of the TINY scanner
+ * compatible with ealier versions of the TINY scanner,
+ * or reads the token buffer of c if it has one
  */
-static int yylex(void)
-{ return getToken(); }
+static int yylex(YYSTYPE * lvalp, int * llocp, Compilation * c)
+{ *lvalp = NULL; /* tokens carry no value; see c->tokenString */
+  if (c->startToken)
+  { c->token = c->startToken;
+    c->startToken = 0;
+  }
+  else if (c->tokens != NULL) c->token = nextToken(c);
+  else c->token = getToken(c);
+  *llocp = c->lineno;
+  return c->token;
+}
 
 TreeNode * parse(void)
-{ 
-  yyparse();
-  return savedTree;
+{ Compilation * c = newCompilation(source);
+  TreeNode * t = parseSource(c);
+  if (c->Error) Error = TRUE;
+  c->arena = NULL; /* the tree outlives c */
+  freeCompilation(c);
+  return t;
+}
+
+/* pull runs the parser picked by YaccParse */
+static int pull(Compilation * c)
+{ return YaccParse ? yyparse(c) : rdparse(c);
+}
+
+TreeNode * parseSource(Compilation * c)
+{ if (ParseThreads != 1) return parseParallel(c,ParseThreads);
+  if (BufferTokens) scanTokens(c);
+  pull(c);
+  return c->savedTree;
 }
 
+TreeNode * reparse(Compilation * c)
+{ c->tokens->cursor = 0;
+  c->tokens->stop = c->tokens->ntokens-1;
+  c->savedTree = NULL;
+  pull(c);
+  return c->savedTree;
+}
+
+TreeNode * parseTokens(Compilation * c, int first, int stop)
+{ int result;
+  c->tokens->cursor = first;
+  c->tokens->stop = stop;
+  c->startToken = DECLIST;
+  c->quiet = TRUE;
+  c->savedTree = NULL;
+  result = pull(c);
+  c->quiet = FALSE;
+  c->tokens->stop = c->tokens->ntokens-1;
+  return result == 0 ? c->savedTree : NULL;
+}
+
+/* pushTokens hands the push parser the tokens of
+ * c that it has not seen yet
+ */
+static void pushTokens(Compilation * c)
+{ TokenBuffer * tb = c->tokens;
+  YYSTYPE value = NULL;
+  int line;
+  tb->stop = tb->ntokens;
+  while (c->pusher != NULL && tb->cursor < tb->ntokens)
+  { c->token = nextToken(c);
+    if (TraceScan) {
+      fprintf(c->listing,"\t%d: ",c->lineno);
+      fprintToken(c->listing,c->token,c->tokenString);
+    }
+    line = c->lineno;
+    if (yypush_parse((yypstate *) c->pusher,c->token,&value,&line,c) != YYPUSH_MORE)
+    { /* accepted, or given up on a syntax error */
+      yypstate_delete((yypstate *) c->pusher);
+      c->pusher = NULL;
+    }
+  }
+}
+
+void parseChunk(Compilation * c, const char * text, long n)
+{ if (c->tokens == NULL)
+  { c->tokens = (TokenBuffer *) calloc(1,sizeof(TokenBuffer));
+    c->pusher = yypstate_new();
+    if (c->tokens==NULL || c->pusher==NULL)
+    { fprintf(listing,"Out of memory error\n");
+      exit(1);
+    }
+    c->lexLine = 1;
+  }
+  growSource(c,c->sourceSize+n);
+  memcpy(c->sourceText+c->sourceSize,text,n);
+  c->sourceSize += n;
+  c->sourceText[c->sourceSize] = c->sourceText[c->sourceSize+1] = '\0';
+  if (c->pusher != NULL)
+  { lexMore(c,FALSE);
+    pushTokens(c);
+  }
+}
+
+TreeNode * parseEnd(Compilation * c)
+{ if (c->tokens == NULL) parseChunk(c,"",0);
+  if (c->pusher != NULL)
+  { lexMore(c,TRUE);
+    pushTokens(c);
+  }
+  return c->savedTree;
+}
@@ -0,0 +1,195 @@
+/****************************************************/
+/* File: compact.c                                  */
+/* Compact syntax trees for the C- compiler         */
+/* The pointer tree built by the parser is copied  */
+/* in one pass into arrays, in the order a          */
+/* traversal visits it                              */
+/****************************************************/
+
+#include <sys/mman.h>
+#include "globals.h"
+#include "compact.h"
+
+/* initial depth of the stacks used to walk trees */
+#define INITDEPTH 256
+
+/* growStack doubles the capacity *cap of the stack
+ * *a of elements of size bytes
+ */
+static void growStack(void * a, int * cap, size_t size)
+{ int n = *cap ? *cap*2 : INITDEPTH;
+  void * p = realloc(*(void **) a,n*size);
+  if (p==NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  *(void **) a = p;
+  *cap = n;
+}
+
+/* initial number of nodes the arrays of a tree hold */
+#define INITNODES 1024
+
+/* growNodes doubles the number of nodes *cap the
+ * arrays of tree hold; the arrays are large enough
+ * that the C library moves most of them by mapping
+ * their pages elsewhere rather than copying them
+ */
+static void growNodes(CompactTree * tree, int * cap)
+{ int n = *cap ? *cap*2 : INITNODES;
+  void * p[8];
+  p[0] = realloc(tree->nodekind,n);
+  if (p[0] != NULL) tree->nodekind = p[0];
+  p[1] = realloc(tree->kind,n);
+  if (p[1] != NULL) tree->kind = p[1];
+  p[2] = realloc(tree->child,n*sizeof(*tree->child));
+  if (p[2] != NULL) tree->child = p[2];
+  p[3] = realloc(tree->sibling,n*sizeof(NodeId));
+  if (p[3] != NULL) tree->sibling = p[3];
+  p[4] = realloc(tree->attr,n*sizeof(Attr));
+  if (p[4] != NULL) tree->attr = p[4];
+  p[5] = realloc(tree->type,n);
+  if (p[5] != NULL) tree->type = p[5];
+  p[6] = realloc(tree->lineno,n*sizeof(int));
+  if (p[6] != NULL) tree->lineno = p[6];
+  p[7] = realloc(tree->size,n*sizeof(int));
+  if (p[7] != NULL) tree->size = p[7];
+  if (p[0] == NULL || p[1] == NULL || p[2] == NULL || p[3] == NULL ||
+      p[4] == NULL || p[5] == NULL || p[6] == NULL || p[7] == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  *cap = n;
+}
+
+/* a node still to be placed, and the node whose
+ * child (slot 0 up) or sibling (slot -1) it is;
+ * numbers rather than pointers, as the arrays move
+ * when they grow
+ */
+typedef struct
+   { TreeNode * node;
+     NodeId parent;
+     int slot;
+   } Pending;
+
+/* place numbers t and its siblings, each followed
+ * by its subtrees, growing the arrays as it goes,
+ * and makes t the root; a node's sibling is pushed
+ * before its children, last child first, so that
+ * they come off the stack in preorder
+ */
+static void place(CompactTree * tree, TreeNode * t)
+{ Pending * stack = NULL;
+  int top = 0, cap = 0, nodes = 0, i;
+  NodeId id;
+  growNodes(tree,&nodes);
+  memset(tree->child[0],0,sizeof(*tree->child));
+  tree->sibling[0] = 0;
+  if (t == NULL) return;
+  growStack(&stack,&cap,sizeof(Pending));
+  stack[top].node = t;
+  stack[top++].parent = 0;
+  while (top > 0)
+  { top--;
+    t = stack[top].node;
+    id = ++tree->nnodes;
+    if (id == (NodeId) nodes) growNodes(tree,&nodes);
+    if (stack[top].parent == 0) tree->root = id;
+    else if (stack[top].slot < 0) tree->sibling[stack[top].parent] = id;
+    else tree->child[stack[top].parent][stack[top].slot] = id;
+    tree->nodekind[id] = t->nodekind;
+    tree->kind[id] = t->kind.exp;
+    tree->attr[id].name = t->attr.name;
+    tree->type[id] = t->nodekind == DecK ? t->type : Void;
+    tree->lineno[id] = t->lineno;
+    tree->size[id] = t->size;
+    memset(tree->child[id],0,sizeof(*tree->child));
+    tree->sibling[id] = 0;
+    if (top+MAXCHILDREN+1 > cap) growStack(&stack,&cap,sizeof(Pending));
+    if (t->sibling != NULL)
+    { stack[top].node = t->sibling;
+      stack[top].parent = id;
+      stack[top++].slot = -1;
+    }
+    for (i=MAXCHILDREN-1;i>=0;i--)
+      if (t->child[i] != NULL)
+      { stack[top].node = t->child[i];
+        stack[top].parent = id;
+        stack[top++].slot = i;
+      }
+  }
+  free(stack);
+}
+
+CompactTree * compactTree(TreeNode * t)
+{ CompactTree * tree = (CompactTree *) calloc(1,sizeof(CompactTree));
+  if (tree == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  place(tree,t);
+  /* filled in by the analysis */
+  tree->scope = (struct ScopeListRec **)
+                calloc(tree->nnodes+1,sizeof(struct ScopeListRec *));
+  tree->binding = (Binding *) calloc(tree->nnodes+1,sizeof(Binding));
+  if (tree->scope == NULL || tree->binding == NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  return tree;
+}
+
+void freeCompactTree(CompactTree * tree)
+{ if (tree == NULL) return;
+  if (tree->image != NULL)
+  { munmap(tree->image,tree->imageSize);
+    free(tree->scope);
+    free(tree->binding);
+    free(tree);
+    return;
+  }
+  free(tree->nodekind); free(tree->kind);
+  free(tree->child); free(tree->sibling);
+  free(tree->attr); free(tree->type);
+  free(tree->lineno); free(tree->size);
+  free(tree->scope);
+  free(tree->binding);
+  free(tree);
+}
+
+/* a node whose subtrees are being walked, and the
+ * next of its children to walk
+ */
+typedef struct
+   { NodeId node;
+     int next;
+   } Frame;
+
+void walkTree(CompactTree * tree, NodeId t,
+              NodeProc preProc, NodeProc postProc, void * arg)
+{ Frame * stack = NULL;
+  int top = 0, cap = 0;
+  while (t != 0)
+  { /* enter t */
+    preProc(t,arg);
+    if (top == cap) growStack(&stack,&cap,sizeof(Frame));
+    stack[top].node = t;
+    stack[top++].next = 0;
+    /* find the next node to enter, leaving the
+     * nodes whose children are all done
+     */
+    t = 0;
+    while (t == 0 && top > 0)
+    { Frame * f = &stack[top-1];
+      if (f->next < MAXCHILDREN)
+        t = tree->child[f->node][f->next++];
+      else
+      { if (postProc != NULL) postProc(f->node,arg);
+        t = tree->sibling[f->node];
+        top--;
+      }
+    }
+  }
+  free(stack);
+}
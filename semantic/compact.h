@@ -0,0 +1,93 @@
+/****************************************************/
+/* File: compact.h                                  */
+/* Compact syntax trees for the C- compiler: the    */
+/* nodes of a tree are numbered in preorder and     */
+/* their fields kept in one array each, so that a   */
+/* traversal reads only the few arrays it needs     */
+/****************************************************/
+
+#ifndef _COMPACT_H_
+#define _COMPACT_H_
+
+/* a node is its index in the arrays; node 0 is no
+ * node, and all its fields read as zero, NULL or
+ * Void
+ */
+typedef unsigned NodeId;
+
+typedef union
+   { TokenType op;
+     int val;
+     char * name;
+   } Attr;
+
+/* the declaration a name at a node resolves to:
+ * its symbol record (see symtab.h), and its address
+ * as the depth of its scope, 0 for Global, and its
+ * location there
+ */
+typedef struct
+   { struct BucketListRec * symbol;
+     int depth;
+     int slot;
+   } Binding;
+
+/* the fields of node t are nodekind[t], kind[t] and
+ * so on; node t+1 is its first child, if any, and
+ * each subtree takes up a run of numbers
+ */
+struct CompactTreeRec
+   { int nnodes;
+     NodeId root;
+     /* hot: read at every node of a traversal */
+     unsigned char * nodekind; /* a NodeKind */
+     unsigned char * kind; /* a StmtKind, ExpKind or DecKind */
+     NodeId (* child)[MAXCHILDREN];
+     NodeId * sibling;
+     /* warm: read by the passes at some nodes */
+     Attr * attr;
+     unsigned char * type; /* an ExpType */
+     /* cold: for messages, listings and scopes */
+     int * lineno;
+     int * size;
+     /* set by buildSymtab: the scope of a compound
+      * statement, and the binding of a use or a
+      * declaration of a name, or of a return to its
+      * function; for a body whose analysis is kept
+      * (see KeepAnalysis) they are copied from the
+      * last compile, like its types
+      */
+     struct ScopeListRec ** scope;
+     Binding * binding;
+     /* when the arrays other than scope and binding
+      * are in a file
+      * mapping (see astcache.h), its address and size
+      */
+     void * image;
+     size_t imageSize;
+   };
+
+/* Function compactTree returns the compact form of
+ * the syntax tree t, which is left alone
+ */
+CompactTree * compactTree(TreeNode * t);
+
+/* Procedure freeCompactTree frees tree */
+void freeCompactTree(CompactTree * tree);
+
+/* a NodeProc is applied by walkTree to a node and
+ * the arg walkTree was given
+ */
+typedef void (* NodeProc) (NodeId, void *);
+
+/* Procedure walkTree applies preProc in preorder and
+ * postProc, unless it is NULL, in postorder to node
+ * t of tree, its siblings and their subtrees, passing
+ * arg along; it keeps its own stack, so neither long
+ * statement lists nor deep expressions can overflow
+ * the C stack
+ */
+void walkTree(CompactTree * tree, NodeId t,
+              NodeProc preProc, NodeProc postProc, void * arg);
+
+#endif
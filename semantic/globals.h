@@ -24,6 +24,12 @@
  * into the Yacc/Bison output itself
  */
 
+/* a Compilation holds the state of the scanner and
+ * the parser for one source (see below); the parser
+ * takes it as a parameter
+ */
+typedef struct CompilationRec Compilation;
+
 #ifndef YYPARSER
 
 /* the name of the following file may change */
@@ -57,8 +63,6 @@ extern FILE* source; /* source code text file */
 extern FILE* listing; /* listing output text file */
 extern FILE* code; /* code text file for TM simulator */
 
-extern int lineno; /* source line number for listing */
-
 /**************************************************/
 /***********   Syntax tree for parsing ************/
 /**************************************************/
@@ -93,11 +97,74 @@ typedef struct treeNode
         char* name;
     } attr;
     int size;
-    ExpType type; /* for type checking of exps */
-    struct ScopeListRec *scope;
+    ExpType type; /* as declared; the types found by type
+                   * checking go into the compact tree */
 
    } TreeNode;
 
+/**************************************************/
+/*********   State of one compilation   ***********/
+/**************************************************/
+
+struct TokenBufferRec; /* see tokbuf.h */
+struct BodyRec; /* see skim.h */
+typedef struct ArenaRec Arena; /* see arena.h */
+typedef struct CompactTreeRec CompactTree; /* see compact.h */
+
+/* The scanner and the parser keep all their state
+ * here rather than in globals, so that separate
+ * sources can be compiled at once on separate
+ * threads (see scan.h and parse.h)
+ */
+struct CompilationRec
+   { FILE * source; /* source code text file */
+     FILE * listing; /* syntax errors and traced tokens go here */
+     int lineno; /* source line number for listing */
+     int Error; /* TRUE once a syntax error occurs */
+     Arena * arena; /* holds the syntax tree, freed along with c */
+
+     /* the scanner */
+     void * lexer; /* the reentrant flex scanner */
+     /* tokenString is the lexeme of the current token,
+      * valid until the next one, except that for an ID
+      * it is the interned name (see intern.h), which
+      * stays valid for good
+      */
+     char * tokenString;
+     /* when the whole source is in memory, sourceText
+      * points at its sourceSize bytes and the current
+      * token is the slice of tokenLength bytes starting
+      * at sourceText[tokenOffset]
+      */
+     char * sourceText;
+     long sourceSize;
+     long tokenOffset;
+     int tokenLength;
+     long mapSize; /* bytes mapped at sourceText, or 0 if malloc'ed */
+     long sourceCapacity; /* bytes malloc'ed at sourceText */
+     struct TokenBufferRec * tokens; /* the token buffer, if any */
+     char * textCopy; /* lexemes copied out of the token buffer */
+     int textCopySize;
+     /* for a source that arrives in chunks (see
+      * parseChunk), where lexing is to go on, on
+      * which line, and whether inside a comment
+      */
+     long lexPos;
+     int lexLine;
+     int lexInComment;
+     /* the function bodies skimSource skipped */
+     struct BodyRec * bodies;
+     int nbodies;
+
+     /* the parser */
+     TokenType token; /* the last token passed to the parser */
+     TokenType startToken; /* token to pass first, if any */
+     int quiet; /* syntax errors are not reported */
+     char * savedName; /* for use in assignments */
+     TreeNode * savedTree; /* stores syntax tree for later return */
+     void * pusher; /* push parser state while chunks arrive */
+   };
+
 /**************************************************/
 /***********   Flags for tracing       ************/
 /**************************************************/
@@ -130,6 +197,79 @@ extern int TraceAnalyze;
  */
 extern int TraceCode;
 
+/* MapSource = TRUE causes the scanner to memory-map
+ * the source file and scan it in place instead of
+ * reading it through stdio
+ */
+extern int MapSource;
+
+/* BufferTokens = TRUE causes the whole source to be
+ * scanned into the token buffer (see tokbuf.h)
+ * before parsing starts; token tracing then comes
+ * out ahead of the rest of the listing
+ */
+extern int BufferTokens;
+
+/* MAXTHREADS is the most threads any pass runs on,
+ * whatever it is asked for
+ */
+#define MAXTHREADS 64
+
+/* ScanThreads is the number of threads scanTokens
+ * may lex a large source on (see plex.h); 0 means
+ * one per processor, 1 keeps to the flex scanner
+ */
+extern int ScanThreads;
+
+/* ParseThreads is the number of threads the
+ * function bodies are parsed on after a skim of the
+ * declarations (see skim.h); 0 means one per
+ * processor, 1 keeps to the sequential parser
+ */
+extern int ParseThreads;
+
+/* AnalyzeThreads is the number of threads a fused
+ * analysis checks function bodies on, once the
+ * declarations of Global are in the table; 0 means
+ * one per processor, 1 keeps to a single walk
+ */
+extern int AnalyzeThreads;
+
+/* YaccParse = TRUE causes the yacc parser of
+ * cminus.y to be used instead of the recursive-
+ * descent one (see rdparse.h); both build the same
+ * trees. Sources that arrive in chunks always go
+ * through the yacc push parser
+ */
+extern int YaccParse;
+
+/* FuseAnalysis = TRUE causes buildSymtab to type
+ * check in the same walk of the tree, holding the
+ * type errors back for typeCheck to list; FALSE
+ * makes typeCheck walk the tree again
+ */
+extern int FuseAnalysis;
+
+/* KeepAnalysis = TRUE causes a fused analysis to
+ * keep what it found in each function body, so that
+ * the next compile analyzes again only the bodies
+ * that changed, or whose uses of Global did
+ */
+extern int KeepAnalysis;
+
+/* CacheDir, if not NULL, is the directory syntax
+ * trees are cached in, keyed by the source text
+ * (see astcache.h), so that compiling an unchanged
+ * source again neither scans nor parses it
+ */
+extern char * CacheDir;
+
+/* ReportTimes = TRUE causes an edit session to print
+ * to stderr how long each recompile took, and a
+ * piped source how long it took to parse
+ */
+extern int ReportTimes;
+
 /* Error = TRUE prevents further passes if an error occurs */
 extern int Error; 
 #endif
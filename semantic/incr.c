@@ -0,0 +1,257 @@
+/****************************************************/
+/* File: incr.c                                     */
+/* Incremental recompilation for the C- compiler    */
+/* The source stays in memory along with its token  */
+/* buffer and the token range of every top-level    */
+/* declaration. An edit is lexed again only as far  */
+/* as the tokens change, and only the declarations  */
+/* over changed tokens are parsed again, as a       */
+/* fragment; all other subtrees are kept           */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "parse.h"
+#include "simdscan.h"
+#include "tokbuf.h"
+#include "plex.h"
+#include "incr.h"
+
+/* the tokens and subtree of a top-level declaration */
+typedef struct
+   { int first, last;
+     TreeNode * tree;
+   } DecRec;
+
+static TreeNode * syntaxTree = NULL;
+static DecRec * decs = NULL;
+static int ndecs = -1; /* -1 if the tree has no valid declaration list */
+static int decCapacity = 0;
+
+/* outOfMemory reports running out of memory and stops */
+static void outOfMemory(void)
+{ fprintf(listing,"Out of memory error\n");
+  exit(1);
+}
+
+/* splitDecs appends to d the token ranges of the
+ * declarations in tokens [first,stop) of tb, judging
+ * by braces and semicolons alone; it returns the new
+ * count, or -1 if a declaration is left open
+ */
+static int splitDecs(TokenBuffer * tb, DecRec ** d, int * cap, int n, int first, int stop)
+{ int i, depth = 0, start = first;
+  for (i=first;i<stop;i++)
+  { int k = tb->kind[i];
+    if (k == LCURLY) depth++;
+    else if (k == RCURLY) depth--;
+    if ((k == SEMI && depth == 0) || (k == RCURLY && depth == 0))
+    { if (n == *cap)
+      { *cap = *cap ? *cap*2 : 256;
+        *d = (DecRec *) realloc(*d,*cap*sizeof(DecRec));
+        if (*d==NULL) outOfMemory();
+      }
+      (*d)[n].first = start;
+      (*d)[n].last = i;
+      n++;
+      start = i+1;
+    }
+  }
+  return start == stop ? n : -1;
+}
+
+/* attachTrees gives the declarations d[0..n) the
+ * subtrees of the list t; it returns FALSE if the
+ * lengths differ
+ */
+static int attachTrees(DecRec * d, int n, TreeNode * t)
+{ int i;
+  for (i=0;i<n;i++,t=t->sibling)
+  { if (t == NULL) return FALSE;
+    d[i].tree = t;
+  }
+  return t == NULL;
+}
+
+/* indexDecs rebuilds the declaration table for
+ * the whole syntax tree of c
+ */
+static void indexDecs(Compilation * c)
+{ ndecs = c->Error ? -1 : splitDecs(c->tokens,&decs,&decCapacity,0,0,c->tokens->ntokens-1);
+  if (ndecs >= 0 && !attachTrees(decs,ndecs,syntaxTree)) ndecs = -1;
+}
+
+/* shiftLines moves t and its siblings, with their
+ * subtrees, by n lines; the stack holds the lists of
+ * children not yet moved, as countNodes in compact.c
+ * does
+ */
+static void shiftLines(TreeNode * t, int n)
+{ TreeNode ** stack = NULL;
+  int top = 0, cap = 0, i;
+  while (t != NULL)
+  { for (; t != NULL; t = t->sibling)
+    { t->lineno += n;
+      for (i=0;i<MAXCHILDREN;i++)
+        if (t->child[i] != NULL)
+        { if (top == cap)
+          { cap = cap ? cap*2 : 256;
+            stack = (TreeNode **) realloc(stack,cap*sizeof(TreeNode *));
+            if (stack==NULL) outOfMemory();
+          }
+          stack[top++] = t->child[i];
+        }
+    }
+    if (top > 0) t = stack[--top];
+  }
+  free(stack);
+}
+
+/* moveTokens moves n tokens of tb from index from
+ * to index to, shifting their offsets by shift and
+ * their lines by lines
+ */
+static void moveTokens(TokenBuffer * tb, int from, int to, int n, long shift, int lines)
+{ int i;
+  memmove(tb->kind+to,tb->kind+from,n*sizeof(short));
+  memmove(tb->start+to,tb->start+from,n*sizeof(long));
+  memmove(tb->len+to,tb->len+from,n*sizeof(int));
+  memmove(tb->line+to,tb->line+from,n*sizeof(int));
+  if (shift != 0 || lines != 0)
+    for (i=to;i<to+n;i++)
+    { tb->start[i] += shift;
+      tb->line[i] += lines;
+    }
+}
+
+TreeNode * openSession(Compilation * c)
+{ /* edits need every token in the buffer, which a
+   * skim for parallel parsing would not leave
+   */
+  BufferTokens = TRUE;
+  ParseThreads = 1;
+  syntaxTree = parseSource(c);
+  indexDecs(c);
+  return syntaxTree;
+}
+
+TreeNode * applyEdit(Compilation * c, long from, long to, const char * text, long n)
+{ static TokenBuffer window;
+  TokenBuffer * tokens = c->tokens;
+  char * sourceText;
+  long shift = n-(to-from);
+  int lines;
+  int k, lo, hi, join, oldCount, delta, first, last, nnew, i;
+  TreeNode * fragment, * prev, * next;
+  DecRec * newDecs = NULL;
+  int newCap = 0;
+
+  /* edit the text */
+  lines = countNewlines(text,text+n) - countNewlines(c->sourceText+from,c->sourceText+to);
+  growSource(c,c->sourceSize+shift);
+  sourceText = c->sourceText;
+  memmove(sourceText+to+shift,sourceText+to,c->sourceSize-to+2);
+  memcpy(sourceText+from,text,n);
+  c->sourceSize += shift;
+
+  /* lex again from the end of the last token that
+   * ends before the edit, where the scanner is
+   * surely outside a comment
+   */
+  oldCount = tokens->ntokens;
+  lo = 0;
+  hi = oldCount-1;
+  while (lo < hi)
+  { int m = (lo+hi)/2;
+    if (tokens->start[m]+tokens->len[m] < from) lo = m+1;
+    else hi = m;
+  }
+  k = lo-1;
+  for (join = k+1; join < oldCount && tokens->start[join] < to; join++)
+    ;
+  window.ntokens = 0;
+  relex(c,&window,k >= 0 ? tokens->start[k]+tokens->len[k] : 0,
+        k >= 0 ? tokens->line[k] : 1,tokens,shift,&join);
+  if (join < 0) join = oldCount;
+  delta = window.ntokens - (join-k-1);
+  reserveTokens(tokens,oldCount+delta);
+  moveTokens(tokens,join,join+delta,oldCount-join,shift,lines);
+  tokens->ntokens = oldCount+delta;
+  for (i=0;i<window.ntokens;i++)
+  { tokens->kind[k+1+i] = window.kind[i];
+    tokens->start[k+1+i] = window.start[i];
+    tokens->len[k+1+i] = window.len[i];
+    tokens->line[k+1+i] = window.line[i];
+  }
+  tokens->stop = tokens->ntokens-1;
+
+  c->Error = FALSE;
+  if (ndecs < 0)
+  { /* the last tree was not a valid program */
+    freeTree(c->arena,syntaxTree);
+    syntaxTree = reparse(c);
+    indexDecs(c);
+    return syntaxTree;
+  }
+
+  /* the declarations lo..hi hold the old tokens
+   * k+1..join-1; the new tokens first..last take
+   * their place
+   */
+  for (lo = 0; lo < ndecs && decs[lo].last <= k; lo++)
+    ;
+  for (hi = lo-1; hi+1 < ndecs && decs[hi+1].first < join; hi++)
+    ;
+  first = lo <= hi ? decs[lo].first : k+1;
+  last = (lo <= hi && decs[hi].last >= join ? decs[hi].last : join-1) + delta;
+  if (join == oldCount) last = tokens->ntokens-2;
+  fragment = first <= last ? parseTokens(c,first,last+1) : NULL;
+  nnew = (first <= last && fragment != NULL) ?
+         splitDecs(tokens,&newDecs,&newCap,0,first,last+1) : 0;
+  if ((first <= last && fragment == NULL) || nnew < 0 ||
+      !attachTrees(newDecs,nnew,fragment))
+  { /* the changed tokens are no declaration list by
+     * themselves: the whole program decides
+     */
+    freeTree(c->arena,fragment);
+    free(newDecs);
+    freeTree(c->arena,syntaxTree);
+    syntaxTree = reparse(c);
+    indexDecs(c);
+    return syntaxTree;
+  }
+
+  /* splice the new subtrees in for the old ones */
+  prev = lo > 0 ? decs[lo-1].tree : NULL;
+  next = hi+1 < ndecs ? decs[hi+1].tree : NULL;
+  if (lo <= hi)
+  { decs[hi].tree->sibling = NULL;
+    freeTree(c->arena,decs[lo].tree);
+  }
+  if (fragment == NULL) fragment = next;
+  else
+  { TreeNode * t = fragment;
+    while (t->sibling != NULL) t = t->sibling;
+    t->sibling = next;
+  }
+  if (prev != NULL) prev->sibling = fragment;
+  else syntaxTree = fragment;
+  if (lines != 0) shiftLines(next,lines);
+
+  /* and the new declarations for the old ones */
+  if (ndecs-(hi-lo+1)+nnew > decCapacity)
+  { decCapacity = (ndecs-(hi-lo+1)+nnew)*2;
+    decs = (DecRec *) realloc(decs,decCapacity*sizeof(DecRec));
+    if (decs==NULL) outOfMemory();
+  }
+  memmove(decs+lo+nnew,decs+hi+1,(ndecs-hi-1)*sizeof(DecRec));
+  memcpy(decs+lo,newDecs,nnew*sizeof(DecRec));
+  for (i=lo+nnew;i<ndecs-(hi-lo+1)+nnew;i++)
+  { decs[i].first += delta;
+    decs[i].last += delta;
+  }
+  ndecs = ndecs-(hi-lo+1)+nnew;
+  free(newDecs);
+  return syntaxTree;
+}
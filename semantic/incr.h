@@ -0,0 +1,30 @@
+/****************************************************/
+/* File: incr.h                                     */
+/* Incremental recompilation for the C- compiler:   */
+/* after an edit only the tokens and top-level      */
+/* declarations it touches are scanned and parsed   */
+/****************************************************/
+
+#ifndef _INCR_H_
+#define _INCR_H_
+
+/* Function openSession scans the source of c into
+ * its token buffer, parses it and returns the syntax
+ * tree; it is the first, cold compile of a session.
+ * There is one session at a time
+ */
+TreeNode * openSession(Compilation * c);
+
+/* Function applyEdit replaces the source bytes of c
+ * from offset from up to offset to by the n chars at
+ * text and returns the syntax tree of the new source.
+ * Tokens are scanned again only from the last one
+ * before the edit up to where they line up with the
+ * old ones, and only the top-level declarations
+ * holding changed tokens are parsed again; the others
+ * keep their subtrees. The range must lie within
+ * the source
+ */
+TreeNode * applyEdit(Compilation * c, long from, long to, const char * text, long n);
+
+#endif
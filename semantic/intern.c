@@ -0,0 +1,84 @@
+/****************************************************/
+/* File: intern.c                                   */
+/* Identifier intern table for the C- compiler      */
+/* (a chained hash table that doubles as it fills)  */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+#include "intern.h"
+
+/* initial number of buckets; always a power of two */
+#define INITSIZE 1024
+
+static Atom * table = NULL;
+static unsigned tableSize = 0;
+static unsigned nAtoms = 0;
+
+/* compilations on separate threads share the table */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* FNV-1a hash of the len chars at s */
+static unsigned hashChars(const char * s, int len)
+{ unsigned h = 2166136261u;
+  int i;
+  for (i=0;i<len;i++)
+  { h ^= (unsigned char) s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* grow rehashes all atoms into twice as many buckets */
+static void grow(void)
+{ unsigned newSize = tableSize ? tableSize*2 : INITSIZE;
+  Atom * newTable = (Atom *) calloc(newSize,sizeof(Atom));
+  unsigned i;
+  if (newTable==NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  for (i=0;i<tableSize;i++)
+  { Atom a = table[i];
+    while (a != NULL)
+    { Atom next = a->next;
+      a->next = newTable[a->hash & (newSize-1)];
+      newTable[a->hash & (newSize-1)] = a;
+      a = next;
+    }
+  }
+  free(table);
+  table = newTable;
+  tableSize = newSize;
+}
+
+char * intern(const char * s, int len)
+{ unsigned h = hashChars(s,len);
+  Atom a;
+  pthread_mutex_lock(&lock);
+  if (tableSize == 0) grow();
+  for (a = table[h & (tableSize-1)]; a != NULL; a = a->next)
+    if (a->hash == h && a->len == len && memcmp(a->name,s,len) == 0)
+    { pthread_mutex_unlock(&lock);
+      return a->name;
+    }
+  if (nAtoms >= tableSize) grow();
+  a = (Atom) malloc(sizeof(struct AtomRec) + len + 1);
+  if (a==NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  a->hash = h;
+  a->len = len;
+  memcpy(a->name,s,len);
+  a->name[len] = '\0';
+  a->next = table[h & (tableSize-1)];
+  table[h & (tableSize-1)] = a;
+  nAtoms++;
+  pthread_mutex_unlock(&lock);
+  return a->name;
+}
+
+char * internString(const char * s)
+{ return intern(s,strlen(s));
+}
@@ -0,0 +1,39 @@
+/****************************************************/
+/* File: intern.h                                   */
+/* Identifier intern table for the C- compiler:     */
+/* every distinct spelling is stored once, so names */
+/* can be compared by pointer                       */
+/****************************************************/
+
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+#include <stddef.h>
+
+/* An atom is the one canonical copy of a spelling,
+ * together with its hash; the scanner and the rest
+ * of the compiler only pass around pointers to the
+ * name field
+ */
+typedef struct AtomRec
+   { struct AtomRec * next; /* chain in the intern table */
+     unsigned hash;
+     int len;
+     char name[];
+   } * Atom;
+
+/* Function intern returns the name of the atom for
+ * the len chars at s, creating it on first use
+ */
+char * intern(const char * s, int len);
+
+/* Function internString interns a NUL-terminated string */
+char * internString(const char * s);
+
+/* atomOf maps a name returned by intern back to its
+ * atom; it must not be applied to any other string
+ */
+#define atomOf(s) ((Atom) ((s) - offsetof(struct AtomRec,name)))
+#define atomHash(s) (atomOf(s)->hash)
+
+#endif
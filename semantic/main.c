@@ -22,13 +22,21 @@
 #include "scan.h"
 #else
 #include "parse.h"
+#include "scan.h"
+#include "incr.h"
+#include "skim.h"
+#include "compact.h"
+#include "astcache.h"
+#include "arena.h"
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
 #if !NO_ANALYZE
 #include "analyze.h"
 #endif
 #endif
 
 /* allocate global variables */
-int lineno = 0;
 FILE * source;
 FILE * listing;
 FILE * code;
@@ -40,16 +48,379 @@ int TraceParse = TRUE;
 int TraceAnalyze = TRUE;
 int TraceCode = FALSE;
 
+int MapSource = TRUE;
+int BufferTokens = FALSE;
+int ScanThreads = 0;
+int ParseThreads = 1;
+int AnalyzeThreads = 1;
+int YaccParse = FALSE;
+char * CacheDir = NULL;
+int FuseAnalysis = TRUE;
+int KeepAnalysis = FALSE;
+int ReportTimes = FALSE;
+
 int Error = FALSE;
 
-main( int argc, char * argv[] )
-{ TreeNode * syntaxTree;
-  char pgm[120]; /* source code file name */
-  if (argc != 2)
-    { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
+#if !NO_PARSE
+/* seconds reads a monotonic clock */
+static double seconds(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/* how long compileTree last took to analyze */
+static double analyzed;
+
+/* compileTree lists and analyzes the compact syntax
+ * tree, then frees it
+ */
+static void compileTree(CompactTree * tree)
+{ double start;
+  if (TraceParse) {
+    fprintf(listing,"\nSyntax tree:\n");
+    printTree(tree);
+  }
+  analyzed = 0;
+#if !NO_ANALYZE
+  if (! Error)
+  { start = seconds();
+    if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table...\n");
+    buildSymtab(tree);
+    if (TraceAnalyze) fprintf(listing,"\nChecking Types...\n");
+    typeCheck(tree);
+    if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
+    analyzed = seconds() - start;
+  }
+#endif
+  freeCompactTree(tree);
+}
+
+/* compile lists and analyzes the syntax tree of an
+ * edit session, both in compact form, keeping the
+ * pointer tree for the edits to come
+ */
+static void compile(TreeNode * syntaxTree)
+{ compileTree(compactTree(syntaxTree));
+}
+
+/* flatten returns the compact form of the syntax
+ * tree of c and frees the pointer tree, which only
+ * an edit session needs once the compact one is
+ * made
+ */
+static CompactTree * flatten(Compilation * c, TreeNode * syntaxTree)
+{ CompactTree * tree = compactTree(syntaxTree);
+  freeArena(c->arena);
+  c->arena = NULL;
+  return tree;
+}
+
+/* parseTree returns the compact syntax tree of the
+ * source of c: with a CacheDir, the one cached for
+ * the same source text if there is one, else the
+ * one parsed, which is cached in turn if it has no
+ * syntax errors
+ */
+static CompactTree * parseTree(Compilation * c)
+{ CompactTree * tree;
+  unsigned long long hash, check;
+  if (CacheDir == NULL) return flatten(c,parseSource(c));
+  holdSource(c);
+  hash = sourceHash(c->sourceText,c->sourceSize,&check);
+  tree = loadCachedTree(CacheDir,hash,check,c->sourceSize);
+  if (tree != NULL) return tree;
+  tree = flatten(c,parseSource(c));
+  if (! c->Error) saveCachedTree(CacheDir,hash,check,c->sourceSize,tree);
+  return tree;
+}
+
+/* editSession compiles the source, then reads edits
+ * from f, each a line "from to n" followed by the n
+ * chars that replace source bytes from..to-1, and
+ * lists the program again after each one, analyzing
+ * again only the function bodies that need it. With
+ * ReportTimes, how long each recompile took, and its
+ * analysis, against the first and cold compile, goes
+ * to stderr
+ */
+static void editSession(FILE * f, char * pgm)
+{ Compilation * c = newCompilation(source);
+  TreeNode * syntaxTree;
+  double start, cold, warm, coldAnalysis;
+  long from, to, n;
+  char * text = NULL;
+  int edits = 0, checked, bodies;
+  KeepAnalysis = TRUE;
+  start = seconds();
+  syntaxTree = openSession(c);
+  Error = c->Error;
+  compile(syntaxTree);
+  cold = seconds() - start;
+  coldAnalysis = analyzed;
+  while (fscanf(f,"%ld %ld %ld",&from,&to,&n) == 3)
+  { if (getc(f) != '\n' || n < 0 ||
+        (text = realloc(text,n+1)) == NULL || fread(text,1,n,f) != (size_t) n)
+    { fprintf(stderr,"bad edit\n");
+      exit(1);
+    }
+    edits++;
+    if (from < 0 || from > to || to > c->sourceSize)
+    { fprintf(stderr,"edit %d: range %ld..%ld is not in the source\n",edits,from,to);
+      continue;
+    }
+    start = seconds();
+    fprintf(listing,"\nCMINUS COMPILATION: %s\n",pgm);
+    syntaxTree = applyEdit(c,from,to,text,n);
+    Error = c->Error;
+    compile(syntaxTree);
+    warm = seconds() - start;
+    if (! ReportTimes) continue;
+    if (c->Error) checked = bodies = 0; /* not analyzed */
+    else checked = bodiesChecked(&bodies);
+    fprintf(stderr,"edit %d: recompiled in %.3f ms, cold compile %.3f ms, saved %.3f ms;"
+            " %d of %d bodies analyzed in %.3f ms, cold %.3f ms\n",
+            edits,warm*1000,cold*1000,(cold-warm)*1000,
+            checked,bodies,analyzed*1000,coldAnalysis*1000);
+  }
+  free(text);
+  freeCompilation(c);
+}
+
+/* throughFile writes the source text of c to a
+ * temporary file and parses that without listing,
+ * as a file compile would, and returns how long it
+ * took, with *written how long the writing did, or
+ * -1 if there is nowhere to write it
+ */
+static double throughFile(Compilation * c, double * written)
+{ char name[] = "/tmp/cminusXXXXXX";
+  Compilation * cold;
+  double start = seconds();
+  int out = mkstemp(name);
+  FILE * f = out < 0 ? NULL : fdopen(out,"w+");
+  if (f == NULL)
+  { if (out >= 0)
+    { close(out);
+      unlink(name);
+    }
+    return -1;
+  }
+  fwrite(c->sourceText,1,c->sourceSize,f);
+  fflush(f);
+  *written = seconds() - start;
+  rewind(f);
+  cold = newCompilation(f);
+  cold->quiet = TRUE;
+  parseSource(cold);
+  freeCompilation(cold);
+  fclose(f);
+  unlink(name);
+  return seconds() - start;
+}
+
+/* streamSource compiles a source read from file
+ * descriptor fd as it arrives, parsing each chunk
+ * at once. With ReportTimes, how long the syntax
+ * tree took from the first byte goes to stderr,
+ * against writing the source to a file once it is
+ * all there and then parsing that
+ */
+static void streamSource(int fd)
+{ Compilation * c = newCompilation(NULL);
+  TreeNode * syntaxTree;
+  char buf[65536];
+  double first = 0, last, done, cold, written;
+  long n;
+  while ((n = read(fd,buf,sizeof(buf))) > 0)
+  { if (first == 0) first = seconds();
+    parseChunk(c,buf,n);
+  }
+  last = seconds();
+  if (first == 0) first = last;
+  syntaxTree = parseEnd(c);
+  done = seconds();
+  Error = c->Error;
+  compileTree(flatten(c,syntaxTree));
+  if (ReportTimes)
+  { cold = throughFile(c,&written);
+    fprintf(stderr,"stream: %ld bytes in %.3f ms; first byte to syntax tree %.3f ms",
+            c->sourceSize,(last-first)*1000,(done-first)*1000);
+    if (cold < 0) fprintf(stderr,", no file to compare with\n");
+    else fprintf(stderr,", through a file %.3f ms (write %.3f ms, parse %.3f ms)\n",
+                 (last-first+cold)*1000,written*1000,(cold-written)*1000);
+  }
+  freeCompilation(c);
+}
+
+/* listSymbols lists the symbol table of the source
+ * from a skim parse, for when only the declarations
+ * are wanted: function bodies are never parsed, so
+ * their locals are missing and the time taken goes
+ * with the number of declarations rather than the
+ * size of the source
+ */
+static void listSymbols(void)
+{ Compilation * c = newCompilation(source);
+  TreeNode * syntaxTree;
+  syntaxTree = skimSource(c);
+  Error = c->Error;
+#if !NO_ANALYZE
+  if (! Error)
+  { CompactTree * tree = flatten(c,syntaxTree);
+    FuseAnalysis = FALSE; /* there is no typeCheck to follow */
+    buildSymtab(tree);
+    freeCompactTree(tree);
+  }
+#endif
+  freeCompilation(c);
+}
+
+/* a source of a run over several files */
+typedef struct
+   { char name[120];
+     Compilation * c;
+     CompactTree * tree;
+     char * errors; /* syntax errors, listed in order later */
+     size_t errorSize;
+   } SourceFile;
+
+static void * parseWorker(void * arg)
+{ SourceFile * f = (SourceFile *) arg;
+  f->tree = parseTree(f->c);
+  return NULL;
+}
+
+/* compileFiles parses the n files at once, each on
+ * a thread of its own, then lists and analyzes them
+ * one after the other
+ */
+static void compileFiles(char * names[], int n)
+{ SourceFile * file = (SourceFile *) calloc(n,sizeof(SourceFile));
+  pthread_t * tid = (pthread_t *) malloc(n*sizeof(pthread_t));
+  int * started = (int *) malloc(n*sizeof(int));
+  FILE * f;
+  int i;
+  if (file==NULL || tid==NULL || started==NULL)
+  { fprintf(stderr,"Out of memory error\n");
+    exit(1);
+  }
+  for (i=0;i<n;i++)
+  { strncpy(file[i].name,names[i],sizeof(file[i].name)-5);
+    if (strchr (file[i].name, '.') == NULL)
+       strcat(file[i].name,".tny");
+    f = fopen(file[i].name,"r");
+    if (f==NULL)
+    { fprintf(stderr,"File %s not found\n",file[i].name);
+      exit(1);
+    }
+    file[i].c = newCompilation(f);
+    file[i].c->listing = open_memstream(&file[i].errors,&file[i].errorSize);
+    if (file[i].c->listing==NULL)
+    { fprintf(stderr,"Out of memory error\n");
       exit(1);
     }
-  strcpy(pgm,argv[1]) ;
+  }
+  for (i=0;i<n;i++)
+    started[i] = pthread_create(&tid[i],NULL,parseWorker,&file[i]) == 0;
+  /* a file whose thread could not start is parsed here */
+  for (i=0;i<n;i++)
+    if (started[i]) pthread_join(tid[i],NULL);
+    else parseWorker(&file[i]);
+  for (i=0;i<n;i++)
+  { fclose(file[i].c->listing);
+    fprintf(listing,"\nCMINUS COMPILATION: %s\n",file[i].name);
+    fwrite(file[i].errors,1,file[i].errorSize,listing);
+    free(file[i].errors);
+    Error = file[i].c->Error;
+    compileTree(file[i].tree);
+    fclose(file[i].c->source);
+    freeCompilation(file[i].c);
+  }
+  free(started);
+  free(tid);
+  free(file);
+}
+#endif
+
+/* usage lists the command line and stops */
+static void usage(char * name)
+{ fprintf(stderr,"usage: %s [-y] [-b | -l threads] [-j threads] [-t] [-c cachedir] [-v] [-i | -s] <filename>\n",name);
+  fprintf(stderr,"       %s [-y] [-b | -l threads] [-j threads] [-t] [-c cachedir] <filename> <filename> ...\n",name);
+  fprintf(stderr,"       %s [-v] - (source on stdin)\n",name);
+  exit(1);
+}
+
+/* threads returns the number of threads given to
+ * flag as arg, which must be from 1 to MAXTHREADS
+ */
+static int threads(char * name, char * flag, char * arg)
+{ char * end;
+  long n = strtol(arg,&end,10);
+  if (end == arg || *end != '\0' || n < 1 || n > MAXTHREADS)
+  { fprintf(stderr,"%s: %s takes a number of threads from 1 to %d\n",name,flag,MAXTHREADS);
+    exit(1);
+  }
+  return n;
+}
+
+int main( int argc, char * argv[] )
+{ char pgm[120]; /* source code file name */
+  int incremental = FALSE, skim = FALSE;
+  int i;
+  /* the flags come first, in any order */
+  for (i=1; i<argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++)
+  { if (strcmp(argv[i],"-y") == 0)
+      /* parse with the yacc parser */
+      YaccParse = TRUE;
+    else if (strcmp(argv[i],"-j") == 0 && i+1 < argc)
+    { /* parse and analyze function bodies on argv[i] threads */
+      ParseThreads = AnalyzeThreads = threads(argv[0],"-j",argv[++i]);
+    }
+    else if (strcmp(argv[i],"-b") == 0)
+      /* scan the whole source into the token buffer first */
+      BufferTokens = TRUE;
+    else if (strcmp(argv[i],"-l") == 0 && i+1 < argc)
+    { /* scan it into the buffer on argv[i] threads */
+      BufferTokens = TRUE;
+      ScanThreads = threads(argv[0],"-l",argv[++i]);
+    }
+    else if (strcmp(argv[i],"-t") == 0)
+      /* build the symbol table and type check in two walks */
+      FuseAnalysis = FALSE;
+    else if (strcmp(argv[i],"-c") == 0 && i+1 < argc)
+      /* cache syntax trees in directory argv[i] */
+      CacheDir = argv[++i];
+    else if (strcmp(argv[i],"-v") == 0)
+      /* time edit sessions and piped sources */
+      ReportTimes = TRUE;
+    else if (strcmp(argv[i],"-i") == 0)
+      /* read edits to the source from stdin */
+      incremental = TRUE;
+    else if (strcmp(argv[i],"-s") == 0)
+      /* list the symbols of a skim parse */
+      skim = TRUE;
+    else usage(argv[0]);
+  }
+  /* the file names follow argv[0] as if no flags came first */
+  argv[i-1] = argv[0];
+  argv += i-1;
+  argc -= i-1;
+  if (argc < 2 || ((incremental || skim) && (argc != 2 || incremental == skim)))
+    usage(argv[0]);
+  listing = stdout; /* send listing to screen */
+#if !NO_PARSE
+  if (argc == 2 && strcmp(argv[1],"-") == 0)
+  { fprintf(listing,"\nCMINUS COMPILATION: -\n");
+    streamSource(0);
+    return 0;
+  }
+  if (argc > 2 && !incremental && !skim)
+  { compileFiles(argv+1,argc-1);
+    return 0;
+  }
+#endif
+  strcpy(pgm,argv[argc-1]) ;
   if (strchr (pgm, '.') == NULL)
      strcat(pgm,".tny");
   source = fopen(pgm,"r");
@@ -57,27 +428,23 @@ main( int argc, char * argv[] )
   { fprintf(stderr,"File %s not found\n",pgm);
     exit(1);
   }
-  listing = stdout; /* send listing to screen */
   fprintf(listing,"\nCMINUS COMPILATION: %s\n",pgm);
 #if NO_PARSE
-  while (getToken()!=ENDFILE);
-#else
-  syntaxTree = parse();
-  if (TraceParse) {
-    fprintf(listing,"\nSyntax tree:\n");
-    printTree(syntaxTree);
+  { Compilation * c = newCompilation(source);
+    while (getToken(c)!=ENDFILE);
+    freeCompilation(c);
   }
-#if !NO_ANALYZE
-  if (! Error)
-  { if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table...\n");
-    buildSymtab(syntaxTree);
-    if (TraceAnalyze) fprintf(listing,"\nChecking Types...\n");
-    typeCheck(syntaxTree);
-    if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
+#else
+  if (incremental) editSession(stdin,pgm);
+  else if (skim) listSymbols();
+  else
+  { Compilation * c = newCompilation(source);
+    CompactTree * tree = parseTree(c);
+    Error = c->Error;
+    compileTree(tree);
+    freeCompilation(c);
   }
-#endif
 #endif
   fclose(source);
   return 0;
 }
-
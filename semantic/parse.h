@@ -9,8 +9,41 @@
 #define _PARSE_H_
 
 /* Function parse returns the newly 
- * constructed syntax tree
+ * constructed syntax tree of the file source
  */
 TreeNode * parse(void);
 
+/* Function parseSource returns the newly
+ * constructed syntax tree of the source of c and
+ * sets c->Error on a syntax error. The parser keeps
+ * its state in c alone, so sources can be parsed
+ * at once on separate threads
+ */
+TreeNode * parseSource(Compilation * c);
+
+/* Function reparse parses the token buffer of c
+ * (see tokbuf.h) again from the start
+ */
+TreeNode * reparse(Compilation * c);
+
+/* Function parseTokens parses the tokens of the
+ * token buffer of c from first up to stop as a
+ * list of declarations, without reporting errors;
+ * it returns NULL if they are not one
+ */
+TreeNode * parseTokens(Compilation * c, int first, int stop);
+
+/* Procedure parseChunk adds the n chars at text to
+ * the source of c, which is to arrive in chunks as
+ * from a pipe rather than from c->source; the chunk
+ * is lexed and parsed as far as it goes right away,
+ * so parsing keeps up with the source as it comes
+ */
+void parseChunk(Compilation * c, const char * text, long n);
+
+/* Function parseEnd ends the source given to c by
+ * parseChunk and returns its syntax tree
+ */
+TreeNode * parseEnd(Compilation * c);
+
 #endif
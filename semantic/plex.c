@@ -0,0 +1,383 @@
+/****************************************************/
+/* File: plex.c                                     */
+/* Parallel lexer for the C- compiler               */
+/* The source is cut into chunks at line breaks.    */
+/* Since only comments span lines, a chunk can only */
+/* start inside or outside a comment: each thread   */
+/* lexes its chunk both ways, and the chunks are    */
+/* then chained in order to pick one of the two     */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+#include "simdscan.h"
+#include "tokbuf.h"
+#include "plex.h"
+
+/* chunks smaller than this are not worth a thread */
+#define MINCHUNK (256*1024)
+
+/* the two ways into a chunk */
+#define OUTSIDE 0
+#define INSIDE 1
+
+typedef struct
+   { const char * text; /* the source */
+     long from, to;    /* the chunk is text[from,to) */
+     int nlines;       /* newlines in the chunk */
+     /* tokens when the chunk is entered OUTSIDE or
+      * INSIDE a comment; lines count from 0 at from
+      */
+     TokenBuffer out[2];
+     /* the INSIDE tokens continue with those of
+      * OUTSIDE from index join on, or join is -1
+      */
+     int join;
+     int endsInComment[2];
+     int sawEOF[2];    /* stopped at the EOF keyword */
+     int way;          /* how the chunk is really entered */
+     int first;        /* index of its first token in the result */
+     int lineBase;     /* line number at from */
+     TokenBuffer * result; /* the buffer the chunks are copied into */
+   } Chunk;
+
+/* token of each character that is a token on its own */
+static const short single[256] =
+   { ['('] = LPAREN, [')'] = RPAREN,
+     ['['] = LBRACE, [']'] = RBRACE,
+     ['{'] = LCURLY, ['}'] = RCURLY,
+     [';'] = SEMI, [','] = COMMA,
+     ['+'] = PLUS, ['-'] = MINUS,
+     ['*'] = TIMES
+   };
+
+/* keyword returns the reserved word or ENDFILE
+ * spelled by the n letters at s, or ID
+ */
+static TokenType keyword(const char * s, int n)
+{ switch (n)
+  { case 2:
+      if (memcmp(s,"if",2) == 0) return IF;
+      break;
+    case 3:
+      if (memcmp(s,"int",3) == 0) return INT;
+      if (memcmp(s,"EOF",3) == 0) return ENDFILE;
+      break;
+    case 4:
+      if (memcmp(s,"else",4) == 0) return ELSE;
+      if (memcmp(s,"void",4) == 0) return VOID;
+      break;
+    case 5:
+      if (memcmp(s,"while",5) == 0) return WHILE;
+      break;
+    case 6:
+      if (memcmp(s,"return",6) == 0) return RETURN;
+      break;
+  }
+  return ID;
+}
+
+#define ISLETTER(c) ((unsigned) (((c) | 0x20) - 'a') < 26)
+#define ISDIGIT(c) ((unsigned) ((c) - '0') < 10)
+
+/* how lexRange stops */
+#define AT_END 0
+#define IN_COMMENT 1
+#define AT_EOF 2
+#define AT_JOIN 3
+#define AT_BRACE 4
+
+/* lexRange appends to tb the tokens of text from p
+ * to to, entered inside a comment if inComment,
+ * with lines counted on from *line. The
+ * rules follow cminus.l: longest match, reserved
+ * words before identifiers, and a comment ends at
+ * the first terminator after its opening.
+ * If other is not NULL, it stops before the first
+ * token that starts where a token j >= *join of
+ * other does, moved by shift, since from there on
+ * the tokens are the same; *join is then set to j.
+ * If brace, it stops after the first '{'
+ */
+static int lexRange(const char * text, TokenBuffer * tb, long p, long to,
+                    int inComment, int * lineno, int brace,
+                    TokenBuffer * other, long shift, int * join)
+{ int line = *lineno;
+  int j = other ? *join : 0;
+  int end = -1;
+  while (p < to)
+  { long s = p;
+    TokenType tok;
+    if (inComment)
+    { const char * e = findCommentEnd(text+p,text+to);
+      long q = e ? e-text+2 : to;
+      line += countNewlines(text+p,text+q);
+      p = q;
+      if (e == NULL) break;
+      inComment = FALSE;
+      continue;
+    }
+    switch (text[p])
+    { case '\n': line++; /* fall through */
+      case ' ': case '\t': p++; continue;
+      case '/':
+        if (text[p+1] == '*')
+        { p += 2;
+          inComment = TRUE;
+          continue;
+        }
+        tok = OVER; p++; break;
+      case '=': tok = text[p+1] == '=' ? (p += 2, EQ) : (p++, ASSIGN); break;
+      case '<': tok = text[p+1] == '=' ? (p += 2, LE) : (p++, LT); break;
+      case '>': tok = text[p+1] == '=' ? (p += 2, GE) : (p++, GT); break;
+      case '!': tok = text[p+1] == '=' ? (p += 2, NE) : (p++, ERROR); break;
+      default:
+        if (ISLETTER(text[p]))
+        { do p++; while (p < to && ISLETTER(text[p]));
+          tok = keyword(text+s,p-s);
+        }
+        else if (ISDIGIT(text[p]))
+        { do p++; while (p < to && ISDIGIT(text[p]));
+          tok = NUM;
+        }
+        else
+        { tok = single[(unsigned char) text[p]];
+          if (tok == 0) tok = ERROR;
+          p++;
+        }
+    }
+    if (other != NULL)
+    { while (j < other->ntokens && other->start[j]+shift < s) j++;
+      if (j < other->ntokens && other->start[j]+shift == s)
+      { *join = j;
+        end = AT_JOIN;
+        break;
+      }
+    }
+    appendToken(tb,tok,s,p-s,line);
+    if (tok == ENDFILE)
+    { end = AT_EOF;
+      break;
+    }
+    if (tok == LCURLY && brace)
+    { end = AT_BRACE;
+      break;
+    }
+  }
+  if (end < 0) end = inComment ? IN_COMMENT : AT_END;
+  *lineno = line;
+  return end;
+}
+
+/* lexChunk lexes chunk c entered the given way; the
+ * INSIDE tokens are joined up with the OUTSIDE ones
+ */
+static void lexChunk(Chunk * c, int way)
+{ int end, line = 0;
+  c->join = 0;
+  end = lexRange(c->text,&c->out[way],c->from,c->to,way == INSIDE,&line,FALSE,
+                 way == INSIDE ? &c->out[OUTSIDE] : NULL,0,&c->join);
+  if (end != AT_JOIN) c->join = -1;
+  c->sawEOF[way] = (end == AT_EOF);
+  c->endsInComment[way] = (end == IN_COMMENT);
+}
+
+static void * lexWorker(void * arg)
+{ Chunk * c = (Chunk *) arg;
+  lexChunk(c,OUTSIDE);
+  if (c->from > 0) lexChunk(c,INSIDE);
+  return NULL;
+}
+
+/* copyRange copies tokens [i,n) of from into result
+ * at index k, shifting their lines
+ */
+static void copyRange(TokenBuffer * result, TokenBuffer * from, int i, int n, int k,
+                      int lineBase)
+{ for (; i < n; i++, k++)
+  { result->kind[k] = from->kind[i];
+    result->start[k] = from->start[i];
+    result->len[k] = from->len[i];
+    result->line[k] = from->line[i] + lineBase;
+  }
+}
+
+static void * copyWorker(void * arg)
+{ Chunk * c = (Chunk *) arg;
+  TokenBuffer * in = &c->out[c->way];
+  copyRange(c->result,in,0,in->ntokens,c->first,c->lineBase);
+  if (c->way == INSIDE && c->join >= 0)
+    copyRange(c->result,&c->out[OUTSIDE],c->join,c->out[OUTSIDE].ntokens,
+              c->first+in->ntokens,c->lineBase);
+  return NULL;
+}
+
+/* runAll runs worker on each of the n chunks */
+static void runAll(void * (* worker) (void *), Chunk * chunk, int n)
+{ pthread_t tid[MAXTHREADS];
+  int started[MAXTHREADS];
+  int i;
+  for (i=1;i<n;i++)
+    started[i] = pthread_create(&tid[i],NULL,worker,&chunk[i]) == 0;
+  worker(&chunk[0]);
+  /* a chunk whose thread could not start is done here */
+  for (i=1;i<n;i++)
+    if (started[i]) pthread_join(tid[i],NULL);
+    else worker(&chunk[i]);
+}
+
+int lexParallel(Compilation * comp, int nthreads)
+{ Chunk chunk[MAXTHREADS];
+  TokenBuffer * tb = comp->tokens;
+  const char * sourceText = comp->sourceText;
+  long sourceSize = comp->sourceSize;
+  int n = nthreads, i, k, way, ntokens, sawEOF;
+  if (n > MAXTHREADS) n = MAXTHREADS;
+  if (n > sourceSize/MINCHUNK) n = sourceSize/MINCHUNK;
+  if (n < 2) return FALSE;
+  memset(chunk,0,sizeof(chunk));
+  /* cut after the first newline past each n-th */
+  for (i=0;i<n;i++)
+  { long to = (i == n-1) ? sourceSize : sourceSize/n*(i+1);
+    char * nl;
+    chunk[i].text = sourceText;
+    chunk[i].result = tb;
+    chunk[i].from = i ? chunk[i-1].to : 0;
+    if (to < chunk[i].from) to = chunk[i].from;
+    nl = to < sourceSize ? memchr(sourceText+to,'\n',sourceSize-to) : NULL;
+    chunk[i].to = (i == n-1 || nl == NULL) ? sourceSize : nl-sourceText+1;
+    reserveTokens(&chunk[i].out[OUTSIDE],(chunk[i].to-chunk[i].from)/4+1);
+  }
+  runAll(lexWorker,chunk,n);
+  /* chain the chunks: each is entered the way the
+   * one before it ends
+   */
+  way = OUTSIDE;
+  ntokens = 0;
+  sawEOF = FALSE;
+  for (i=0;i<n;i++)
+  { Chunk * c = &chunk[i];
+    c->way = way;
+    c->first = ntokens;
+    c->lineBase = comp->lineno;
+    if (sawEOF)
+    { c->out[way].ntokens = 0;
+      c->join = -1;
+      continue;
+    }
+    c->nlines = countNewlines(sourceText+c->from,sourceText+c->to);
+    comp->lineno += c->nlines;
+    ntokens += c->out[way].ntokens;
+    if (way == INSIDE && c->join >= 0)
+    { ntokens += c->out[OUTSIDE].ntokens - c->join;
+      way = OUTSIDE;
+    }
+    sawEOF = c->sawEOF[way];
+    way = c->endsInComment[way] ? INSIDE : OUTSIDE;
+  }
+  reserveTokens(tb,ntokens+1);
+  runAll(copyWorker,chunk,n);
+  tb->ntokens = ntokens;
+  if (sawEOF)
+    /* lineno stops at the line of the EOF keyword */
+    comp->lineno = tb->line[ntokens-1];
+  else
+    /* flex reports the end with a one-char
+     * lexeme at the end of the source
+     */
+    appendToken(tb,ENDFILE,sourceSize,1,comp->lineno);
+  for (i=0;i<n;i++)
+  { for (k=0;k<2;k++)
+    { free(chunk[i].out[k].kind); free(chunk[i].out[k].start);
+      free(chunk[i].out[k].len); free(chunk[i].out[k].line);
+    }
+  }
+  return TRUE;
+}
+
+void relex(Compilation * c, TokenBuffer * tb, long p, int line,
+           TokenBuffer * old, long shift, int * join)
+{ long sourceSize = c->sourceSize;
+  int end, j;
+  end = lexRange(c->sourceText,tb,p,sourceSize,FALSE,&line,FALSE,old,shift,join);
+  if (end == AT_JOIN) return;
+  j = old->ntokens-1;
+  if (end != AT_EOF && j >= *join && old->kind[j] == ENDFILE
+      && old->start[j]+shift == sourceSize)
+  { /* the end of the source joins the final ENDFILE */
+    *join = j;
+    return;
+  }
+  if (end != AT_EOF) appendToken(tb,ENDFILE,sourceSize,1,line);
+  *join = -1;
+}
+
+int lexMore(Compilation * c, int final)
+{ TokenBuffer * tb = c->tokens;
+  const char * text = c->sourceText;
+  long to = c->sourceSize;
+  int end;
+  if (tb->ntokens > 0 && tb->kind[tb->ntokens-1] == ENDFILE) return TRUE;
+  if (!final)
+  { while (to > c->lexPos && text[to-1] != '\n') to--;
+    if (to == c->lexPos) return FALSE;
+  }
+  end = lexRange(text,tb,c->lexPos,to,c->lexInComment,&c->lexLine,FALSE,NULL,0,NULL);
+  c->lexPos = to;
+  c->lexInComment = (end == IN_COMMENT);
+  if (end == AT_EOF) return TRUE;
+  if (final)
+  { appendToken(tb,ENDFILE,to,1,c->lexLine);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+int lexUntilBrace(Compilation * c, long * p, int * line)
+{ TokenBuffer * tb = c->tokens;
+  int end;
+  end = lexRange(c->sourceText,tb,*p,c->sourceSize,FALSE,line,TRUE,NULL,0,NULL);
+  if (end == AT_BRACE)
+  { *p = tb->start[tb->ntokens-1]+1;
+    return TRUE;
+  }
+  if (end != AT_EOF) appendToken(tb,ENDFILE,c->sourceSize,1,*line);
+  *p = c->sourceSize;
+  return FALSE;
+}
+
+long skipBody(Compilation * c, long p, int * line)
+{ const char * text = c->sourceText, * end = text+c->sourceSize, * e;
+  int depth = 1;
+  long n;
+  while (p < c->sourceSize)
+  { n = spanBodyText(text+p,end);
+    *line += countNewlines(text+p,text+p+n);
+    p += n;
+    if (p == c->sourceSize) break;
+    switch (text[p++])
+    { case '{': depth++; break;
+      case '}': if (--depth == 0) return p; break;
+      case 'E':
+        /* the EOF keyword ends the tokens, as in lexRange */
+        if (c->sourceSize - p >= 2 && text[p] == 'O' && text[p+1] == 'F'
+            && (p < 2 || !ISLETTER(text[p-2]))
+            && (c->sourceSize - p == 2 || !ISLETTER(text[p+2])))
+          return -1;
+        break;
+      case '/':
+        if (text[p] != '*') break;
+        e = findCommentEnd(text+p+1,end);
+        n = e ? e-text+2 : c->sourceSize;
+        *line += countNewlines(text+p,text+n);
+        p = n;
+    }
+  }
+  return -1;
+}
+
+void lexBody(Compilation * c, long from, long to, int line)
+{ TokenBuffer * tb = c->tokens;
+  if (lexRange(c->sourceText,tb,from,to,FALSE,&line,FALSE,NULL,0,NULL) != AT_EOF)
+    appendToken(tb,ENDFILE,to,1,line);
+}
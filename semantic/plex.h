@@ -0,0 +1,66 @@
+/****************************************************/
+/* File: plex.h                                     */
+/* Parallel lexer for the C- compiler: scans large  */
+/* sources in chunks on several threads, giving the */
+/* same tokens as the flex scanner                  */
+/****************************************************/
+
+#ifndef _PLEX_H_
+#define _PLEX_H_
+
+/* Function lexParallel scans the source text of c
+ * into its token buffer on up to nthreads threads
+ * and leaves c->lineno at the last line, as
+ * scanTokens does. Returns FALSE without touching
+ * the buffer if the source is too small to be worth
+ * splitting
+ */
+int lexParallel(Compilation * c, int nthreads);
+
+/* Procedure relex lexes the source of c again after
+ * an edit, from offset p outside any comment, on line
+ * line, appending to tb. old holds the tokens from
+ * before the edit, whose text after the edit has
+ * moved by shift bytes. relex stops before the first
+ * token that starts where a token j >= *join of old
+ * now does, as the rest is unchanged, and sets *join
+ * to j; otherwise it lexes to the final ENDFILE and
+ * sets *join to -1
+ */
+void relex(Compilation * c, TokenBuffer * tb, long p, int line,
+           TokenBuffer * old, long shift, int * join);
+
+/* Function lexMore lexes the source text of c that
+ * arrived since the last call into its token buffer.
+ * Unless final, more text is to come, so it stops
+ * after the last newline, where no token can be cut
+ * in two. Returns TRUE once the buffer ends with
+ * ENDFILE, which final adds if need be
+ */
+int lexMore(Compilation * c, int final);
+
+/* Function lexUntilBrace lexes the source of c into
+ * its token buffer from offset *p, outside any
+ * comment, on line *line, up to and including the
+ * next '{', and leaves *p and *line just after it.
+ * Returns FALSE if it got to the end instead, which
+ * is then followed by ENDFILE
+ */
+int lexUntilBrace(Compilation * c, long * p, int * line);
+
+/* Function skipBody skips the source of c from offset
+ * p, just after a '{', up to the matching '}', looking
+ * at braces and comments alone, and counts on *line
+ * the newlines it passes. Returns the offset after
+ * the '}', or -1 if there is none or the EOF keyword,
+ * which ends the tokens, comes first
+ */
+long skipBody(Compilation * c, long p, int * line);
+
+/* Procedure lexBody appends to the token buffer of c
+ * the tokens of the source from offset from up to
+ * offset to, starting on line line, then ENDFILE
+ */
+void lexBody(Compilation * c, long from, long to, int line);
+
+#endif
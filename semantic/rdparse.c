@@ -0,0 +1,417 @@
+/****************************************************/
+/* File: rdparse.c                                  */
+/* Recursive-descent parser for the C- compiler     */
+/* It accepts the grammar of cminus.y and makes the */
+/* same trees, down to the line numbers. Like the   */
+/* yacc parser it reads a token only once it has to */
+/* look at it, so c->lineno and c->tokenString are  */
+/* the same as in the matching yacc action whenever */
+/* a node is made                                   */
+/****************************************************/
+
+#include <setjmp.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "tokbuf.h"
+#include "rdparse.h"
+
+/* binding strength of the binary operators */
+#define NOT_BINARY 0
+#define RELATIONAL 1
+#define ADDITIVE 2
+#define MULTIPLICATIVE 3
+
+typedef struct
+   { Compilation * c;
+     int ahead; /* c->token is read but not yet matched */
+     jmp_buf fail; /* where a syntax error ends up */
+   } Parser;
+
+static TreeNode * statement(Parser * p);
+static TreeNode * expression(Parser * p);
+
+/* syntaxError reports the current token as yyerror
+ * does and gives up on the parse
+ */
+static void syntaxError(Parser * p)
+{ Compilation * c = p->c;
+  if (!c->quiet)
+  { flockfile(c->listing);
+    fprintf(c->listing,"Syntax error at line %d: syntax error\n",c->lineno);
+    fprintf(c->listing,"Current token: ");
+    fprintToken(c->listing,c->token,c->tokenString);
+    funlockfile(c->listing);
+    c->Error = TRUE;
+  }
+  longjmp(p->fail,1);
+}
+
+/* peek returns the next token, reading it if need be */
+static TokenType peek(Parser * p)
+{ Compilation * c = p->c;
+  if (!p->ahead)
+  { if (c->startToken)
+    { c->token = c->startToken;
+      c->startToken = 0;
+    }
+    else if (c->tokens != NULL) c->token = nextToken(c);
+    else c->token = getToken(c);
+    p->ahead = TRUE;
+  }
+  return c->token;
+}
+
+/* match moves past the next token, which must be
+ * expected; it does not read the one after
+ */
+static void match(Parser * p, TokenType expected)
+{ if (peek(p) != expected) syntaxError(p);
+  p->ahead = FALSE;
+}
+
+static int precedence(TokenType token)
+{ switch (token)
+  { case LE: case LT: case GT: case GE: case EQ: case NE:
+      return RELATIONAL;
+    case PLUS: case MINUS:
+      return ADDITIVE;
+    case TIMES: case OVER:
+      return MULTIPLICATIVE;
+    default:
+      return NOT_BINARY;
+  }
+}
+
+/* arguments parses the possibly empty argument list
+ * of a call up to the closing parenthesis
+ */
+static TreeNode * arguments(Parser * p)
+{ TreeNode * first = NULL, * last = NULL, * t;
+  if (peek(p) == RPAREN) return NULL;
+  do
+  { t = expression(p);
+    if (t != NULL)
+    { if (last == NULL) first = t;
+      else last->sibling = t;
+      last = t;
+    }
+  } while (peek(p) == COMMA && (match(p,COMMA), TRUE));
+  return first;
+}
+
+/* primary parses a number, variable, call or an
+ * expression in parentheses; *isVar tells whether
+ * it was a variable, which may be assigned to
+ */
+static TreeNode * primary(Parser * p, int * isVar)
+{ Compilation * c = p->c;
+  TreeNode * t;
+  char * name;
+  *isVar = FALSE;
+  switch (peek(p))
+  { case LPAREN:
+      match(p,LPAREN);
+      t = expression(p);
+      match(p,RPAREN);
+      return t;
+    case NUM:
+      match(p,NUM);
+      t = newExpNode(c->arena,ConstK,c->lineno);
+      t->attr.val = atoi(c->tokenString);
+      return t;
+    case ID:
+      match(p,ID);
+      name = c->tokenString; /* interned by the scanner */
+      switch (peek(p))
+      { case LPAREN:
+          t = newExpNode(c->arena,CallK,c->lineno);
+          t->attr.name = name;
+          match(p,LPAREN);
+          t->child[0] = arguments(p);
+          match(p,RPAREN);
+          return t;
+        case LBRACE:
+          t = newExpNode(c->arena,ArrIdK,c->lineno);
+          t->attr.name = name;
+          match(p,LBRACE);
+          t->child[0] = expression(p);
+          match(p,RBRACE);
+          break;
+        default:
+          t = newExpNode(c->arena,IdK,c->lineno);
+          t->attr.name = name;
+      }
+      *isVar = TRUE;
+      return t;
+    default:
+      syntaxError(p);
+      return NULL;
+  }
+}
+
+/* newOpNode makes the node of a binary operation */
+static TreeNode * newOpNode(Compilation * c, TokenType op, int lineno, TreeNode * left, TreeNode * right)
+{ TreeNode * t = newExpNode(c->arena,OpK,lineno);
+  t->attr.op = op;
+  t->child[0] = left;
+  t->child[1] = right;
+  return t;
+}
+
+/* binary parses the operators binding at least as
+ * strongly as level that follow the operand left;
+ * comparisons do not chain
+ */
+static TreeNode * binary(Parser * p, TreeNode * left, int level)
+{ Compilation * c = p->c;
+  int prec, isVar;
+  while ((prec = precedence(peek(p))) >= level)
+  { TokenType op = c->token;
+    int lineno = c->lineno;
+    TreeNode * right;
+    match(p,op);
+    right = primary(p,&isVar);
+    if (precedence(peek(p)) > prec) right = binary(p,right,prec+1);
+    left = newOpNode(c,op,lineno,left,right);
+    if (prec == RELATIONAL && precedence(peek(p)) == RELATIONAL) syntaxError(p);
+  }
+  return left;
+}
+
+static TreeNode * expression(Parser * p)
+{ int isVar;
+  TreeNode * t = primary(p,&isVar), * source;
+  if (isVar && peek(p) == ASSIGN)
+  { match(p,ASSIGN);
+    source = expression(p);
+    t = newOpNode(p->c,ASSIGN,p->c->lineno,t,source);
+  }
+  else t = binary(p,t,RELATIONAL);
+  return t;
+}
+
+/* compound parses a compound statement, its local
+ * declarations and then its statements
+ */
+static TreeNode * compound(Parser * p)
+{ Compilation * c = p->c;
+  TreeNode * decs = NULL, * stmts = NULL, * last = NULL, * t;
+  match(p,LCURLY);
+  while (peek(p) == INT || peek(p) == VOID)
+  { match(p,c->token);
+    t = newDecNode(c->arena,VarK,c->lineno);
+    t->type = c->token == INT ? Integer : Void;
+    match(p,ID);
+    t->attr.name = c->tokenString;
+    if (peek(p) == LBRACE)
+    { t->type = Array;
+      match(p,LBRACE);
+      match(p,NUM);
+      t->size = atoi(c->tokenString);
+      match(p,RBRACE);
+    }
+    match(p,SEMI);
+    if (last == NULL) decs = t;
+    else last->sibling = t;
+    last = t;
+  }
+  last = NULL;
+  while (peek(p) != RCURLY)
+  { t = statement(p);
+    if (t != NULL)
+    { if (last == NULL) stmts = t;
+      else last->sibling = t;
+      last = t;
+    }
+  }
+  match(p,RCURLY);
+  t = newStmtNode(c->arena,CompK,c->lineno);
+  t->child[0] = decs;
+  t->child[1] = stmts;
+  return t;
+}
+
+static TreeNode * statement(Parser * p)
+{ Compilation * c = p->c;
+  TreeNode * t, * test, * body;
+  switch (peek(p))
+  { case LCURLY:
+      return compound(p);
+    case IF:
+      match(p,IF);
+      match(p,LPAREN);
+      test = expression(p);
+      match(p,RPAREN);
+      body = statement(p);
+      if (peek(p) == ELSE)
+      { TreeNode * other;
+        match(p,ELSE);
+        other = statement(p);
+        t = newStmtNode(c->arena,IfK,c->lineno);
+        t->child[2] = other;
+      }
+      else
+      { t = newStmtNode(c->arena,IfK,c->lineno);
+        t->child[2] = NULL;
+      }
+      t->child[0] = test;
+      t->child[1] = body;
+      return t;
+    case WHILE:
+      match(p,WHILE);
+      match(p,LPAREN);
+      test = expression(p);
+      match(p,RPAREN);
+      body = statement(p);
+      t = newStmtNode(c->arena,WhileK,c->lineno);
+      t->child[0] = test;
+      t->child[1] = body;
+      return t;
+    case RETURN:
+      match(p,RETURN);
+      if (peek(p) == SEMI)
+      { match(p,SEMI);
+        return newStmtNode(c->arena,RetK,c->lineno);
+      }
+      body = expression(p);
+      match(p,SEMI);
+      t = newStmtNode(c->arena,RetK,c->lineno);
+      t->child[0] = body;
+      return t;
+    case SEMI:
+      match(p,SEMI);
+      return NULL;
+    default:
+      t = expression(p);
+      match(p,SEMI);
+      return t;
+  }
+}
+
+/* param parses a parameter whose type has been
+ * matched and made into the node t
+ */
+static TreeNode * param(Parser * p, TreeNode * t)
+{ Compilation * c = p->c;
+  match(p,ID);
+  t->kind.dec = ParamK;
+  t->attr.name = c->tokenString;
+  if (peek(p) == LBRACE)
+  { match(p,LBRACE);
+    match(p,RBRACE);
+    t->type = Array;
+    t->size = 0;
+  }
+  return t;
+}
+
+/* params parses the parameters of a function up to
+ * the closing parenthesis
+ */
+static TreeNode * params(Parser * p)
+{ Compilation * c = p->c;
+  TreeNode * first, * last, * t;
+  if (peek(p) == VOID)
+  { match(p,VOID);
+    /* void alone, or the type of a first parameter;
+     * yacc looks at the next token to tell, so the
+     * node gets its line
+     */
+    if (peek(p) == RPAREN) t = newDecNode(c->arena,ParamK,c->lineno);
+    else t = newDecNode(c->arena,VarK,c->lineno);
+    t->type = Void;
+    if (c->token == RPAREN) return t;
+  }
+  else
+  { match(p,INT);
+    t = newDecNode(c->arena,VarK,c->lineno);
+    t->type = Integer;
+  }
+  first = last = param(p,t);
+  while (peek(p) == COMMA)
+  { match(p,COMMA);
+    if (peek(p) != INT) match(p,VOID);
+    else match(p,INT);
+    t = newDecNode(c->arena,VarK,c->lineno);
+    t->type = c->token == INT ? Integer : Void;
+    last->sibling = param(p,t);
+    last = last->sibling;
+  }
+  return first;
+}
+
+/* declaration parses a variable or function
+ * declaration at the top level
+ */
+static TreeNode * declaration(Parser * p)
+{ Compilation * c = p->c;
+  TreeNode * t;
+  if (peek(p) != INT) match(p,VOID);
+  else match(p,INT);
+  t = newDecNode(c->arena,VarK,c->lineno);
+  t->type = c->token == INT ? Integer : Void;
+  match(p,ID);
+  t->attr.name = c->tokenString;
+  switch (peek(p))
+  { case LBRACE:
+      t->type = Array;
+      match(p,LBRACE);
+      match(p,NUM);
+      t->size = atoi(c->tokenString);
+      match(p,RBRACE);
+      match(p,SEMI);
+      break;
+    case LPAREN:
+      t->kind.dec = FunK;
+      match(p,LPAREN);
+      t->child[0] = params(p);
+      match(p,RPAREN);
+      t->child[1] = compound(p);
+      break;
+    default:
+      match(p,SEMI);
+  }
+  return t;
+}
+
+/* declarationList parses the declarations of the
+ * program and returns the first
+ */
+static TreeNode * declarationList(Parser * p)
+{ TreeNode * first = NULL, * last = NULL, * t;
+  do
+  { t = declaration(p);
+    if (last == NULL) first = t;
+    else last->sibling = t;
+    last = t;
+  } while (peek(p) == INT || peek(p) == VOID);
+  return first;
+}
+
+int rdparse(Compilation * c)
+{ Parser p;
+  p.c = c;
+  p.ahead = FALSE;
+  if (setjmp(p.fail)) return 1;
+  if (peek(&p) == DECLIST) match(&p,DECLIST);
+  /* yacc takes the declarations so far for the
+   * program before it finds out that a token after
+   * them is amiss
+   */
+  c->savedTree = declarationList(&p);
+  if (c->token != ENDFILE) syntaxError(&p);
+  return 0;
+}
+
+int rdparseBody(Compilation * c)
+{ Parser p;
+  TreeNode * t;
+  p.c = c;
+  p.ahead = FALSE;
+  if (setjmp(p.fail)) return 1;
+  t = compound(&p);
+  if (peek(&p) != ENDFILE) syntaxError(&p);
+  c->savedTree = t;
+  return 0;
+}
@@ -0,0 +1,24 @@
+/****************************************************/
+/* File: rdparse.h                                  */
+/* Recursive-descent parser for the C- compiler: an */
+/* alternative to the yacc parser of cminus.y that  */
+/* builds the same syntax trees                     */
+/****************************************************/
+
+#ifndef _RDPARSE_H_
+#define _RDPARSE_H_
+
+/* Function rdparse parses the tokens of c as yyparse
+ * does: it returns 0 and sets c->savedTree if they
+ * are a program, or reports the first syntax error
+ * as yyparse would and returns 1
+ */
+int rdparse(Compilation * c);
+
+/* Function rdparseBody parses the tokens of c as a
+ * lone compound statement, a function body, in the
+ * same way
+ */
+int rdparseBody(Compilation * c);
+
+#endif
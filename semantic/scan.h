@@ -8,16 +8,34 @@
 #ifndef _SCAN_H_
 #define _SCAN_H_
 
-/* MAXTOKENLEN is the maximum size of a token */
-#define MAXTOKENLEN 40
+/* Function newCompilation sets up the scanning and
+ * parsing of the file source; each compilation has
+ * a scanner of its own, so that several can run at
+ * once on separate threads
+ */
+Compilation * newCompilation(FILE * source);
 
-/* tokenString array stores the lexeme of each token */
-extern char tokenString[MAXTOKENLEN+1];
-extern char numString[MAXTOKENLEN+1];
+/* Procedure freeCompilation frees c along with its
+ * scanner, source text, token buffer and arena, and
+ * so with the syntax tree built in it
+ */
+void freeCompilation(Compilation * c);
 
 /* function getToken returns the 
- * next token in source file
+ * next token in the source file of c
+ */
+TokenType getToken(Compilation * c);
+
+/* Procedure holdSource brings the whole source of
+ * c into memory at c->sourceText before any of it
+ * is scanned
+ */
+void holdSource(Compilation * c);
+
+/* Procedure growSource makes room for the source
+ * text of c to grow to size bytes, moving it off
+ * the mapping of the file if need be
  */
-TokenType getToken(void);
+void growSource(Compilation * c, long size);
 
 #endif
@@ -0,0 +1,126 @@
+/****************************************************/
+/* File: simdscan.c                                 */
+/* Vectorized character-span helpers for the        */
+/* scanners (SSE2, or AVX2 when compiled with       */
+/* -mavx2), with a scalar fallback                  */
+/****************************************************/
+
+#include <stddef.h>
+#include "simdscan.h"
+
+/* scalar character tests, also used for the tail
+ * shorter than one vector
+ */
+#define ISBLANK(c) ((c) == ' ' || (c) == '\t')
+#define ISWHITE(c) (ISBLANK(c) || (c) == '\n')
+#define ISLETTER(c) ((unsigned) (((c) | 0x20) - 'a') < 26)
+#define ISDIGIT(c) ((unsigned) ((c) - '0') < 10)
+#define ISBODYTEXT(c) ((c) != '{' && (c) != '}' && (c) != '/' && (c) != 'E')
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VLEN 32
+#define FULL 0xffffffffu
+typedef __m256i vec;
+#define vload(p) _mm256_loadu_si256((const __m256i *) (p))
+#define vset(c) _mm256_set1_epi8((char) (c))
+#define veq(a,b) _mm256_cmpeq_epi8(a,b)
+#define vor(a,b) _mm256_or_si256(a,b)
+#define vadd(a,b) _mm256_add_epi8(a,b)
+#define vlt(a,b) _mm256_cmpgt_epi8(b,a)
+#define vmask(v) ((unsigned) _mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VLEN 16
+#define FULL 0xffffu
+typedef __m128i vec;
+#define vload(p) _mm_loadu_si128((const __m128i *) (p))
+#define vset(c) _mm_set1_epi8((char) (c))
+#define veq(a,b) _mm_cmpeq_epi8(a,b)
+#define vor(a,b) _mm_or_si128(a,b)
+#define vadd(a,b) _mm_add_epi8(a,b)
+#define vlt(a,b) _mm_cmplt_epi8(a,b)
+#define vmask(v) ((unsigned) _mm_movemask_epi8(v))
+#endif
+
+#ifdef VLEN
+/* the class masks have bit i set when byte i of
+ * the vector is in the class; (c-lo) < n unsigned
+ * is computed as a signed compare biased by -128
+ */
+static unsigned rangeMask(vec v, int lo, int n)
+{ return vmask(vlt(vadd(v,vset(-128-lo)),vset(-128+n)));
+}
+
+#define BLANKMASK(v) vmask(vor(veq(v,vset(' ')),veq(v,vset('\t'))))
+#define WHITEMASK(v) (BLANKMASK(v) | vmask(veq(v,vset('\n'))))
+#define LETTERMASK(v) rangeMask(vor(v,vset(0x20)),'a',26)
+#define DIGITMASK(v) rangeMask(v,'0',10)
+#define BODYTEXTMASK(v) (~vmask(vor(vor(veq(v,vset('{')),veq(v,vset('}'))), \
+                                    vor(veq(v,vset('/')),veq(v,vset('E'))))) & FULL)
+
+/* SPAN skips whole vectors of class members and
+ * stops at the first non-member in a vector
+ */
+#define SPAN(MASK,TEST) \
+  { const char * p = s; \
+    while (end - p >= VLEN) \
+    { unsigned m = ~MASK(vload(p)) & FULL; \
+      if (m) return p - s + __builtin_ctz(m); \
+      p += VLEN; \
+    } \
+    while (p < end && TEST(*p)) p++; \
+    return p - s; \
+  }
+#else
+#define SPAN(MASK,TEST) \
+  { const char * p = s; \
+    while (p < end && TEST(*p)) p++; \
+    return p - s; \
+  }
+#endif
+
+long spanBlanks(const char * s, const char * end)
+SPAN(BLANKMASK,ISBLANK)
+
+long spanWhite(const char * s, const char * end)
+SPAN(WHITEMASK,ISWHITE)
+
+long spanLetters(const char * s, const char * end)
+SPAN(LETTERMASK,ISLETTER)
+
+long spanDigits(const char * s, const char * end)
+SPAN(DIGITMASK,ISDIGIT)
+
+long spanBodyText(const char * s, const char * end)
+SPAN(BODYTEXTMASK,ISBODYTEXT)
+
+const char * findCommentEnd(const char * s, const char * end)
+{ const char * p = s;
+#ifdef VLEN
+  /* a '*' at byte i and a '/' at byte i+1 */
+  while (end - p > VLEN)
+  { unsigned m = vmask(veq(vload(p),vset('*')))
+               & vmask(veq(vload(p+1),vset('/')));
+    if (m) return p + __builtin_ctz(m);
+    p += VLEN;
+  }
+#endif
+  for (; end - p > 1; p++)
+    if (p[0] == '*' && p[1] == '/') return p;
+  return NULL;
+}
+
+long countNewlines(const char * s, const char * end)
+{ const char * p = s;
+  long n = 0;
+#ifdef VLEN
+  while (end - p >= VLEN)
+  { n += __builtin_popcount(vmask(veq(vload(p),vset('\n'))));
+    p += VLEN;
+  }
+#endif
+  for (; p < end; p++)
+    if (*p == '\n') n++;
+  return n;
+}
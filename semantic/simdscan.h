@@ -0,0 +1,45 @@
+/****************************************************/
+/* File: simdscan.h                                 */
+/* Vectorized character-span helpers for the        */
+/* scanners: each looks at 16 (SSE2) or 32 (AVX2)   */
+/* bytes per step and has a scalar fallback         */
+/****************************************************/
+
+#ifndef _SIMDSCAN_H_
+#define _SIMDSCAN_H_
+
+/* each function looks only at the bytes in [s,end) */
+
+/* spanBlanks returns the length of the run of
+ * blanks and tabs at s
+ */
+long spanBlanks(const char * s, const char * end);
+
+/* spanWhite is spanBlanks that also takes in
+ * newlines
+ */
+long spanWhite(const char * s, const char * end);
+
+/* spanLetters and spanDigits return the length of
+ * the run of [a-zA-Z] resp. [0-9] characters at s
+ */
+long spanLetters(const char * s, const char * end);
+long spanDigits(const char * s, const char * end);
+
+/* spanBodyText returns the length of the run of
+ * chars at s other than braces, slashes and 'E',
+ * the only ones that matter when skipping a
+ * function body ('E' may begin the EOF keyword)
+ */
+long spanBodyText(const char * s, const char * end);
+
+/* findCommentEnd returns a pointer to the '*' of
+ * the first comment terminator at or after s, or
+ * NULL if there is none wholly before end
+ */
+const char * findCommentEnd(const char * s, const char * end);
+
+/* countNewlines returns the number of newlines */
+long countNewlines(const char * s, const char * end);
+
+#endif
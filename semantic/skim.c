@@ -0,0 +1,214 @@
+/****************************************************/
+/* File: skim.c                                     */
+/* Skim parsing for the C- compiler                 */
+/* At the top level a '{' can only open a function  */
+/* body, so the source is lexed up to each '{' and  */
+/* the body is passed over by brace matching alone, */
+/* leaving a '}' token in its place. The parser     */
+/* then sees every function with an empty body.     */
+/* A body is lexed and parsed only when asked for   */
+/****************************************************/
+
+#include <pthread.h>
+#include <unistd.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "parse.h"
+#include "tokbuf.h"
+#include "plex.h"
+#include "rdparse.h"
+#include "skim.h"
+#include "arena.h"
+
+/* outOfMemory reports running out of memory and stops */
+static void outOfMemory(void)
+{ fprintf(listing,"Out of memory error\n");
+  exit(1);
+}
+
+/* skimTokens lexes the source of c into its token
+ * buffer with every function body skipped, noting
+ * the bodies in c->bodies
+ */
+static void skimTokens(Compilation * c)
+{ TokenBuffer * tb;
+  Body * b;
+  long p = 0, q;
+  int line, cap = 0;
+  holdSource(c);
+  c->tokens = (TokenBuffer *) calloc(1,sizeof(TokenBuffer));
+  if (c->tokens==NULL) outOfMemory();
+  tb = c->tokens;
+  line = c->lineno;
+  while (lexUntilBrace(c,&p,&line))
+  { int bodyLine = line;
+    q = skipBody(c,p,&line);
+    if (q < 0)
+    { /* the body is left open: lex it in full, for the
+       * parser to report what a full parse would
+       */
+      lexBody(c,p,c->sourceSize,bodyLine);
+      break;
+    }
+    if (c->nbodies == cap)
+    { cap = cap ? cap*2 : 256;
+      c->bodies = (Body *) realloc(c->bodies,cap*sizeof(Body));
+      if (c->bodies==NULL) outOfMemory();
+    }
+    b = &c->bodies[c->nbodies++];
+    b->from = p-1;
+    b->to = q;
+    b->line = tb->line[tb->ntokens-1];
+    appendToken(tb,RCURLY,q-1,1,line);
+    p = q;
+  }
+}
+
+/* parseRange lexes body b after the tokens in the
+ * token buffer of c, parses it and drops its tokens
+ * again; it returns the compound statement, or NULL
+ * on a syntax error
+ */
+static TreeNode * parseRange(Compilation * c, Body * b)
+{ TokenBuffer * tb = c->tokens;
+  TreeNode * saved = c->savedTree, * body;
+  int mark = tb->ntokens, result;
+  lexBody(c,b->from,b->to,b->line);
+  tb->cursor = mark;
+  tb->stop = tb->ntokens-1;
+  result = rdparseBody(c);
+  body = c->savedTree;
+  tb->ntokens = mark;
+  tb->stop = mark-1;
+  c->savedTree = saved;
+  return result == 0 ? body : NULL;
+}
+
+TreeNode * skimSource(Compilation * c)
+{ TreeNode * t;
+  int i = 0;
+  skimTokens(c);
+  reparse(c);
+  /* the functions come in the order of their bodies */
+  for (t = c->savedTree; t != NULL; t = t->sibling)
+    if (t->nodekind == DecK && t->kind.dec == FunK && t->child[1] != NULL)
+      t->child[1]->attr.val = ++i;
+  return c->savedTree;
+}
+
+TreeNode * parseBody(Compilation * c, TreeNode * fun)
+{ TreeNode * t = fun->child[1], * body;
+  if (t == NULL || t->attr.val == 0) return t;
+  body = parseRange(c,&c->bodies[t->attr.val-1]);
+  if (body == NULL) return NULL;
+  t->child[0] = body->child[0];
+  t->child[1] = body->child[1];
+  t->attr.val = 0;
+  body->child[0] = body->child[1] = NULL;
+  freeTree(c->arena,body);
+  return t;
+}
+
+/* the bodies [first,last) parsed by one thread, with
+ * a compilation of its own over the same source
+ */
+typedef struct
+   { Compilation * c;
+     Body * bodies;
+     TreeNode ** trees;
+     int first, last;
+     int failed; /* a body has a syntax error */
+   } Worker;
+
+static void * bodyWorker(void * arg)
+{ Worker * w = (Worker *) arg;
+  int i;
+  for (i=w->first;i<w->last && !w->failed;i++)
+  { w->trees[i] = parseRange(w->c,&w->bodies[i]);
+    if (w->trees[i] == NULL) w->failed = TRUE;
+  }
+  return NULL;
+}
+
+/* parseBodies parses all bodies of c on up to
+ * nthreads threads, each taking a run of bodies of
+ * about the same size, into trees; it returns FALSE
+ * if one has a syntax error
+ */
+static int parseBodies(Compilation * c, TreeNode ** trees, int nthreads)
+{ Worker worker[MAXTHREADS];
+  pthread_t tid[MAXTHREADS];
+  int started[MAXTHREADS];
+  long total, share;
+  int n = nthreads, i, k = 0, ok = TRUE;
+  if (n > MAXTHREADS) n = MAXTHREADS;
+  if (n > c->nbodies) n = c->nbodies;
+  if (n < 1) return TRUE;
+  total = c->bodies[c->nbodies-1].to - c->bodies[0].from;
+  for (i=0;i<n;i++)
+  { Worker * w = &worker[i];
+    w->c = newCompilation(NULL);
+    w->c->tokens = (TokenBuffer *) calloc(1,sizeof(TokenBuffer));
+    if (w->c->tokens==NULL) outOfMemory();
+    w->c->sourceText = c->sourceText;
+    w->c->sourceSize = c->sourceSize;
+    w->c->listing = c->listing;
+    w->c->quiet = TRUE;
+    w->bodies = c->bodies;
+    w->trees = trees;
+    w->failed = FALSE;
+    w->first = k;
+    share = c->bodies[0].from + total/n*(i+1);
+    if (i == n-1) k = c->nbodies;
+    else while (k < c->nbodies && c->bodies[k].to <= share) k++;
+    w->last = k;
+  }
+  for (i=1;i<n;i++)
+    started[i] = pthread_create(&tid[i],NULL,bodyWorker,&worker[i]) == 0;
+  bodyWorker(&worker[0]);
+  /* bodies whose thread could not start are done here */
+  for (i=1;i<n;i++)
+    if (started[i]) pthread_join(tid[i],NULL);
+    else bodyWorker(&worker[i]);
+  for (i=0;i<n;i++)
+  { if (worker[i].failed) ok = FALSE;
+    /* the trees are built in the worker's arena */
+    joinArena(c->arena,worker[i].c->arena);
+    worker[i].c->sourceText = NULL; /* it is c's */
+    freeCompilation(worker[i].c);
+  }
+  return ok;
+}
+
+TreeNode * parseParallel(Compilation * c, int nthreads)
+{ TreeNode * tree, * t, ** trees;
+  int i = 0, line;
+  if (nthreads == 0) nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+  skimTokens(c);
+  line = c->lineno;
+  trees = (TreeNode **) calloc(c->nbodies+1,sizeof(TreeNode *));
+  if (trees==NULL) outOfMemory();
+  tree = parseTokens(c,0,c->tokens->ntokens-1);
+  if (tree != NULL && parseBodies(c,trees,nthreads))
+  { /* splice the bodies in, in source order */
+    for (t = tree; t != NULL; t = t->sibling)
+      if (t->nodekind == DecK && t->kind.dec == FunK && t->child[1] != NULL)
+      { freeTree(c->arena,t->child[1]);
+        t->child[1] = trees[i++];
+      }
+    c->savedTree = tree;
+  }
+  else
+  { /* a syntax error: parse it all again in order, so
+     * that the same error is reported, and the same
+     * partial tree kept, as by the sequential parser
+     */
+    c->tokens->ntokens = 0;
+    c->nbodies = 0;
+    lexBody(c,0,c->sourceSize,line);
+    reparse(c);
+  }
+  free(trees);
+  return c->savedTree;
+}
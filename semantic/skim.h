@@ -0,0 +1,48 @@
+/****************************************************/
+/* File: skim.h                                     */
+/* Skim parsing for the C- compiler: declarations   */
+/* and signatures are parsed in full, but function  */
+/* bodies are only brace-matched and parsed when    */
+/* asked for                                        */
+/****************************************************/
+
+#ifndef _SKIM_H_
+#define _SKIM_H_
+
+/* a skipped function body: the source bytes
+ * [from,to) from its '{' through its '}', the '{'
+ * on line line
+ */
+typedef struct BodyRec
+   { long from, to;
+     int line;
+   } Body;
+
+/* Function skimSource returns the syntax tree of the
+ * source of c with every function body left empty:
+ * its compound statement has no children yet and
+ * attr.val is one more than its index in c->bodies.
+ * Syntax errors outside bodies are reported as a
+ * full parse would; those inside show up only once
+ * the body is parsed
+ */
+TreeNode * skimSource(Compilation * c);
+
+/* Function parseBody fills in the body of function
+ * fun of the tree skimSource made, unless it is
+ * there already, and returns it; on a syntax error
+ * in it, which it reports, it returns NULL
+ */
+TreeNode * parseBody(Compilation * c, TreeNode * fun);
+
+/* Function parseParallel returns the syntax tree of
+ * the source of c as parseSource does, parsing the
+ * function bodies found by a skim on up to nthreads
+ * threads (0 means one per processor) and splicing
+ * them in. On a syntax error the source is parsed
+ * again in order, so errors and trees are those of
+ * the sequential parser
+ */
+TreeNode * parseParallel(Compilation * c, int nthreads);
+
+#endif
@@ -2,8 +2,8 @@
 /* File: symtab.c                                   */
 /* Symbol table implementation for the TINY compiler*/
 /* (allows only one symbol table)                   */
-/* Symbol table is implemented as a chained         */
-/* hash table                                       */
+/* Each scope is an open-addressing hash table      */
+/* that grows with its records                      */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -13,38 +13,141 @@
 #include <string.h>
 #include "globals.h"
 #include "symtab.h"
+#include "intern.h"
+#include "arena.h"
 
 
-#define SHIFT 4
 char *typeString[] = {"void", "int", "int[]"};
 
-static int hash ( char * key )
-{ int temp = 0;
-  int i = 0;
-  while (key[i] != '\0')
-  { temp = ((temp << SHIFT) + key[i]) % SIZE;
-    ++i;
+/* names are atoms, so the hash comes precomputed;
+ * it is spread over 64 bits, whose top bits pick
+ * the first slot to probe
+ */
+#define hash(key) (atomHash(key) * 0x9E3779B97F4A7C15ull)
+#define firstSlot(h,bits) ((unsigned) ((h) >> (64 - (bits))))
+
+/* the slots a scope starts with, as a power of two */
+#define MINBITS 2
+
+/* the table is kept per thread, so that threads
+ * can analyze functions side by side (see st_fork)
+ */
+static __thread ScopeList * totalScope = NULL;
+static __thread int ntotalScope = 0, totalCap = 0;
+static __thread ScopeList * scopeStack = NULL;
+static __thread int nScopeStack = 0, stackCap = 0;
+static __thread int * location = NULL;
+/* all scopes and records, given back by st_reset */
+static __thread Arena * arena = NULL;
+
+/* a line added to a record of Global while lines
+ * are held back, and the node it was added for
+ */
+struct PendingLineRec
+   { BucketList l;
+     char * name; /* of l, which st_rebase looks up again */
+     int lineno;
+     unsigned node;
+   };
+
+/* whether lines for Global are held back, and those
+ * held so far
+ */
+static __thread int holding = FALSE;
+static __thread struct PendingLineRec * pending = NULL;
+static __thread int npending = 0, pendingCap = 0;
+
+/* the last node whose record of Global st_lookup
+ * may return, or 0 for no limit
+ */
+static __thread unsigned visibleBefore = 0;
+
+/* stAlloc takes n bytes for the table from its arena */
+static void * stAlloc(size_t n)
+{ void * p;
+  if (arena == NULL) arena = newArena();
+  p = arena != NULL ? arenaAlloc(arena,n) : NULL;
+  if (p == NULL)
+  { fprintf(stderr,"Out of memory error\n");
+    exit(1);
   }
-  return temp;
+  return p;
 }
 
-static ScopeList totalScope[1000];
-static int ntotalScope = 0;
-static ScopeList scopeStack[1000];
-static int nScopeStack = 0;
-static int location[1000];
+/* grow doubles the vector at *v, of *cap items of
+ * size n, or gives it a first 64
+ */
+static void grow(void * v, int * cap, size_t n)
+{ void * p;
+  *cap = *cap ? *cap*2 : 64;
+  p = realloc(*(void **) v,*cap*n);
+  if (p == NULL)
+  { fprintf(stderr,"Out of memory error\n");
+    exit(1);
+  }
+  *(void **) v = p;
+}
+
+/* find returns the record of name, whose hash is h,
+ * in scope sc, or NULL
+ */
+static BucketList find(ScopeList sc, unsigned long long h, char * name)
+{ unsigned mask, i;
+  BucketList l;
+  if (sc->slot == NULL) return NULL;
+  mask = (1u << sc->bits) - 1;
+  for (i = firstSlot(h,sc->bits); (l = sc->slot[i]) != NULL; i = (i+1) & mask)
+    if (l->name == name) return l;
+  return NULL;
+}
+
+/* place puts l, which is not there, in the first
+ * free slot for h in scope sc
+ */
+static void place(ScopeList sc, unsigned long long h, BucketList l)
+{ unsigned mask = (1u << sc->bits) - 1;
+  unsigned i = firstSlot(h,sc->bits);
+  while (sc->slot[i] != NULL) i = (i+1) & mask;
+  sc->slot[i] = l;
+}
+
+/* addRecord enters l in scope sc, doubling its slots
+ * first if that would fill more than half of them;
+ * the slots outgrown stay in the arena until
+ * st_reset
+ */
+static void addRecord(ScopeList sc, unsigned long long h, BucketList l)
+{ if (sc->slot == NULL || 2*(sc->count+1) > (1 << sc->bits))
+  { BucketList * old = sc->slot;
+    int n = old ? 1 << sc->bits : 0;
+    int i;
+    sc->bits = old ? sc->bits+1 : MINBITS;
+    sc->slot = (BucketList *) stAlloc(sizeof(BucketList) << sc->bits);
+    memset(sc->slot,0,sizeof(BucketList) << sc->bits);
+    for (i=0;i<n;i++)
+      if (old[i] != NULL) place(sc,hash(old[i]->name),old[i]);
+  }
+  place(sc,h,l);
+  sc->count++;
+  l->next = sc->records;
+  sc->records = l;
+}
 
 ScopeList scope_top(){
+  if (nScopeStack == 0) return NULL;
   return scopeStack[nScopeStack - 1];
 }
 
 ScopeList scope_create(char *name){
   ScopeList new;
 
-  new = (ScopeList) malloc(sizeof(struct ScopeListRec));
+  new = (ScopeList) stAlloc(sizeof(struct ScopeListRec));
+  memset(new,0,sizeof(struct ScopeListRec));
   new->name = name;
   new-> parent = scope_top();
+  new->depth = new->parent ? new->parent->depth+1 : 0;
 
+  if (ntotalScope == totalCap) grow(&totalScope,&totalCap,sizeof(ScopeList));
   totalScope[ntotalScope++] = new;
   return new;
 }
@@ -54,26 +157,41 @@ void scope_pop(){
 }
 
 void scope_push(ScopeList scope){
+  if (nScopeStack == stackCap)
+  { int cap = stackCap;
+    grow(&location,&cap,sizeof(int));
+    grow(&scopeStack,&stackCap,sizeof(ScopeList));
+  }
   scopeStack[nScopeStack] = scope;
   location[nScopeStack++] = 0;
 }
 
+void st_reset(){
+  freeArena(arena);
+  arena = NULL;
+  ntotalScope = 0;
+  nScopeStack = 0;
+  npending = 0;
+  holding = FALSE;
+  visibleBefore = 0;
+}
+
 int addLocation(){
   return location[nScopeStack - 1]++;
 }
 
 
 BucketList st_lookup (char * name){
-  int h = hash(name);
+  unsigned long long h = hash(name);
   ScopeList sc = scope_top();
 
   while(sc){
-      BucketList l = sc->bucket[h];
-      while(l!=NULL){
-        if(strcmp(l->name, name) == 0) return l;
-        l = l->next;
-      }
-    
+    BucketList l = find(sc,h,name);
+    if(l!=NULL){
+      if(sc->depth == 0 && visibleBefore != 0 && l->node > visibleBefore)
+        return NULL;
+      return l;
+    }
     sc = sc->parent;
   }
   
@@ -81,106 +199,231 @@ BucketList st_lookup (char * name){
 }
 
 BucketList st_lookup_excluding_parent ( char * scope, char * name){
-  int h = hash(name);
   ScopeList sc = scope_top();
   
-  if(strcmp(sc->name, scope)){
-    BucketList l = sc->bucket[h];
-    while(l!=NULL){
-      if(strcmp(l->name, name) == 0) return l;
-      l = l->next;
-    }  
-  }
+  if(sc->name != scope)
+    return find(sc,hash(name),name);
 
   return NULL;
 }
 
-void st_insert(char *scope, char * name, ExpType type, int lineno, int loc, TreeNode *t)
+BucketList st_insert(char *scope, char * name, ExpType type, int lineno, int loc, unsigned node)
 { 
-  int h = hash(name);
+  unsigned long long h = hash(name);
   ScopeList sc = scope_top();
   
 
   while(sc){
-    if(strcmp(sc->name, scope) == 0){
+    if(sc->name == scope){
       break;
     }
 
     sc = sc->parent;
   }
-  BucketList l =  sc->bucket[h];
-
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
-    l = l->next;
+  BucketList l = find(sc,h,name);
 
   if (l == NULL) /* variable not yet in table */
   { 
 
-    l = (BucketList) malloc(sizeof(struct BucketListRec));
+    l = (BucketList) stAlloc(sizeof(struct BucketListRec));
     l->name = name;
     
-    l->lines = (LineList) malloc(sizeof(struct LineListRec));
+    l->lines = (LineList) stAlloc(sizeof(struct LineListRec));
     l->lines->lineno = lineno;
     l->lines->next = NULL;
+    l->lastLine = l->lines;
     
     l->type = type;
     l->memloc = loc;
-    l->next = sc->bucket[h];
-    l->treenode = t;
-    sc->bucket[h] = l;
+    l->depth = sc->depth;
+    l->node = node;
+    l->arity = -1;
+    l->params = NULL;
+    addRecord(sc,h,l);
   }
   
   else /* found in table, so just add line number */
-  {
-    LineList t = l->lines;
+    just_add_line(l, lineno, node);
+  return l;
+} /* st_insert */
 
-    while (t->next != NULL) t = t->next;
-    t->next = (LineList) malloc(sizeof(struct LineListRec));
-    t->next->lineno = lineno;
-    t->next->next = NULL;
+ExpType * st_params(BucketList l, int arity){
+  l->arity = arity;
+  l->params = arity ? (ExpType *) stAlloc(arity*sizeof(ExpType)) : NULL;
+  return l->params;
+}
+
+/* holdLine holds back line p */
+static void holdLine(struct PendingLineRec p){
+  if (npending == pendingCap)
+  { pendingCap = pendingCap ? pendingCap*2 : 256;
+    pending = (struct PendingLineRec *)
+              realloc(pending,pendingCap*sizeof(struct PendingLineRec));
+    if (pending == NULL)
+    { fprintf(stderr,"Out of memory error\n");
+      exit(1);
+    }
   }
-} /* st_insert */
+  pending[npending++] = p;
+}
 
-void just_add_line(char * name, int lineno){
+void just_add_line(BucketList l, int lineno, unsigned node){
 
-  BucketList l = st_lookup(name);
-  
-  LineList t = l->lines;
+  LineList t;
+  if (holding && l->depth == 0)
+  { struct PendingLineRec p;
+    p.l = l;
+    p.name = l->name;
+    p.lineno = lineno;
+    p.node = node;
+    holdLine(p);
+    return;
+  }
+  t = (LineList) stAlloc(sizeof(struct LineListRec));
+  t->lineno = lineno;
+  t->next = NULL;
+  l->lastLine->next = t;
+  l->lastLine = t;
+}
+
+void st_fork(ScopeList global){
+  nScopeStack = 0;
+  ntotalScope = 0;
+  arena = NULL;
+  npending = 0;
+  holding = TRUE;
+  visibleBefore = 0;
+  scope_push(global);
+}
+
+void st_visible(unsigned limit){
+  visibleBefore = limit;
+}
+
+void st_detach(SymtabPart * part){
+  part->scopes = totalScope;
+  part->nscopes = ntotalScope;
+  part->arena = arena;
+  part->lines = pending;
+  part->nlines = npending;
+  totalScope = NULL;
+  ntotalScope = totalCap = 0;
+  free(scopeStack);
+  free(location);
+  scopeStack = NULL;
+  location = NULL;
+  nScopeStack = stackCap = 0;
+  arena = NULL;
+  pending = NULL;
+  npending = pendingCap = 0;
+  holding = FALSE;
+  visibleBefore = 0;
+}
+
+void st_share(SymtabPart * part){
+  int i;
+  for (i=0;i<part->nscopes;i++)
+  { if (ntotalScope == totalCap) grow(&totalScope,&totalCap,sizeof(ScopeList));
+    totalScope[ntotalScope++] = part->scopes[i];
+  }
+  for (i=0;i<part->nlines;i++)
+    holdLine(part->lines[i]);
+}
 
-  while (t->next != NULL) t = t->next;
-  t->next = (LineList) malloc(sizeof(struct LineListRec));
-  t->next->lineno = lineno;
-  t->next->next = NULL;
+void st_join(SymtabPart * part){
+  st_share(part);
+  free(part->scopes);
+  if (part->arena != NULL)
+  { if (arena == NULL) arena = newArena();
+    joinArena(arena,part->arena);
+    freeArena(part->arena);
+  }
+  free(part->lines);
+}
+
+void st_drop(SymtabPart * part){
+  free(part->scopes);
+  freeArena(part->arena);
+  free(part->lines);
+}
+
+void st_rebase(SymtabPart * part, int nodes, int lines){
+  int i;
+  for (i=0;i<part->nscopes;i++)
+  { ScopeList sc = part->scopes[i];
+    if (sc->depth == 1) sc->parent = scope_top();
+    sc->lineShift += lines;
+  }
+  for (i=0;i<part->nlines;i++)
+  { struct PendingLineRec * p = &part->lines[i];
+    p->node += nodes;
+    p->lineno += lines;
+    p->l = st_lookup(p->name);
+  }
+}
+
+/* byNode orders held lines as a walk in order would
+ * have added them
+ */
+static int byNode(const void * a, const void * b){
+  unsigned x = ((const struct PendingLineRec *) a)->node;
+  unsigned y = ((const struct PendingLineRec *) b)->node;
+  return x < y ? -1 : x > y;
+}
+
+void st_hold_lines(int hold){
+  int i;
+  holding = hold;
+  if (hold) return;
+  if (npending > 1)
+    qsort(pending,npending,sizeof(struct PendingLineRec),byNode);
+  for (i=0;i<npending;i++)
+    just_add_line(pending[i].l,pending[i].lineno,pending[i].node);
+  free(pending);
+  pending = NULL;
+  npending = pendingCap = 0;
 }
 
 void printSymTab(FILE * listing){
   int i;
   int j;
+  int start[SIZE+1];
+  BucketList * order = NULL;
+  int orderCap = 0;
   fprintf(listing,"Variable Name\tType\tLocation\tScope\t\tLine Numbers\n");
   fprintf(listing,"-------------\t-----\t---------\t------\t\t-------------\n");
   
   for(j = 0 ; j < ntotalScope; j++){
     ScopeList sc = totalScope[j];
+    BucketList l;
 
+    /* sort the records by bucket, newest first in
+     * each, as the chained table used to hold them
+     */
+    while (orderCap < sc->count) grow(&order,&orderCap,sizeof(BucketList));
+    memset(start,0,sizeof(start));
+    for (l = sc->records; l != NULL; l = l->next)
+      start[atomHash(l->name) % SIZE + 1]++;
     for (i=0;i<SIZE;++i)
-    { if (sc->bucket[i] != NULL)
-      {
-        BucketList l = sc->bucket[i];
-        while (l != NULL)
-        { LineList t = l->lines;
-          fprintf(listing,"%s\t\t",l->name);
-          fprintf(listing,"%s\t\t", typeString[l->type]);
-          fprintf(listing,"%d\t",l->memloc);
-          fprintf(listing,"%s\t\t",sc->name);
-          while (t != NULL)
-          { fprintf(listing,"%d,",t->lineno);
-            t = t->next;
-          }
-          fprintf(listing,"\n");
-          l = l->next;
-        }
+      start[i+1] += start[i];
+    for (l = sc->records; l != NULL; l = l->next)
+      order[start[atomHash(l->name) % SIZE]++] = l;
+
+    for (i=0;i<sc->count;++i)
+    { LineList t;
+      l = order[i];
+      t = l->lines;
+      fprintf(listing,"%s\t\t",l->name);
+      fprintf(listing,"%s\t\t", typeString[l->type]);
+      fprintf(listing,"%d\t",l->memloc);
+      fprintf(listing,"%s\t\t",sc->name);
+      while (t != NULL)
+      { fprintf(listing,"%d,",t->lineno + sc->lineShift);
+        t = t->next;
       }
+      fprintf(listing,"\n");
     }
   }
+  free(order);
 }
 /* printSymTab */
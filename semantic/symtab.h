@@ -11,7 +11,10 @@
 
 
 
-/* SIZE is the size of the hash table */
+/* printSymTab lists the records of a scope in the
+ * order of a chained hash table of SIZE buckets,
+ * which the table once was
+ */
 #define SIZE 211
 /* the list of line numbers of the source 
  * code in which a variable is referenced
@@ -25,20 +28,33 @@ typedef struct LineListRec
  * each variable, including name, 
  * assigned memory location, and
  * the list of line numbers in which
- * it appears in the source code
+ * it appears in the source code.
+ * Names here and in the interface below
+ * are atoms (see intern.h) and are
+ * compared by pointer
  */
 typedef struct BucketListRec
    { char * name;
      ExpType type;
      LineList lines;
      int memloc ; /* memory location for variable */
-     struct BucketListRec * next;
-     TreeNode *treenode;
+     int depth; /* of its scope, 0 for Global */
+     LineList lastLine; /* the end of lines */
+     struct BucketListRec * next; /* declared before it in its scope */
+     unsigned node; /* its declaration in the compact tree
+                     * (see compact.h), or 0 if built in */
+     int arity; /* of a function, -1 for a variable */
+     ExpType * params; /* the types of a function's parameters */
    } * BucketList;
 
 typedef struct ScopeListRec{
   char * name;
-  BucketList bucket[SIZE];
+  int depth; /* how many scopes enclose it */
+  int lineShift; /* added to the lines of its records (see st_rebase) */
+  BucketList * slot; /* open addressing, NULL while it is empty */
+  int bits; /* there are 1 << bits slots */
+  int count; /* records in slot */
+  BucketList records; /* newest first */
   struct ScopeListRec * parent;
 } * ScopeList;
 
@@ -46,14 +62,85 @@ ScopeList scope_top();
 ScopeList scope_create(char *name);
 void scope_pop();
 void scope_push(ScopeList scope);
-void st_insert( char * scope, char * name, ExpType type, int lineno, int loc, TreeNode *t);
-void just_add_line(char * name, int lineno);
+/* st_insert returns the record of name in scope,
+ * which is new unless name is there already
+ */
+BucketList st_insert( char * scope, char * name, ExpType type, int lineno, int loc, unsigned node);
+/* st_params gives l, a function, arity parameters
+ * and returns the vector of their types, for the
+ * caller to fill in
+ */
+ExpType * st_params(BucketList l, int arity);
+/* just_add_line adds lineno, for the reference at
+ * node, to the lines of l
+ */
+void just_add_line(BucketList l, int lineno, unsigned node);
 int addLocation();
 
+/* st_reset drops all scopes so that the
+ * table can be built again; the table keeps its
+ * records in an arena, which goes in one piece
+ */
+void st_reset();
+
 //BucketList st_lookup ( char * scope, char * name);
 BucketList st_lookup (char * name);
 BucketList st_lookup_excluding_parent ( char * scope, char * name);
 
+/* the scopes, records and held lines a thread
+ * built after st_fork, for st_join to take in
+ */
+typedef struct
+   { ScopeList * scopes;
+     int nscopes;
+     Arena * arena;
+     struct PendingLineRec * lines;
+     int nlines;
+   } SymtabPart;
+
+/* The table is kept per thread. st_fork starts the
+ * calling thread's table afresh inside scope global,
+ * whose records it must not change: lines added to
+ * them are held back until the part is joined
+ */
+void st_fork(ScopeList global);
+/* st_visible hides from st_lookup the records of
+ * Global declared after node limit; 0 shows all
+ */
+void st_visible(unsigned limit);
+/* st_detach hands the calling thread's scopes,
+ * records and held lines over to part, leaving its
+ * table empty
+ */
+void st_detach(SymtabPart * part);
+/* st_join adds the scopes of part after those of the
+ * calling thread's table, which takes over its
+ * records and held lines
+ */
+void st_join(SymtabPart * part);
+/* st_share adds the scopes and held lines of part as
+ * st_join does, but part stays the caller's, to be
+ * shared again by a later table or dropped
+ */
+void st_share(SymtabPart * part);
+/* st_drop frees part */
+void st_drop(SymtabPart * part);
+/* st_rebase moves part, built for a function whose
+ * nodes and lines have all moved by the same amounts
+ * since, along with it: its function's scope is put
+ * inside the calling thread's top scope, and its
+ * held lines go to the records st_lookup finds there
+ * now for the same names. Its own records keep the
+ * nodes they were declared at, and their lines are
+ * shifted as they are listed
+ */
+void st_rebase(SymtabPart * part, int nodes, int lines);
+/* st_hold_lines(TRUE) holds back the lines added to
+ * records of Global; st_hold_lines(FALSE) adds
+ * those held in the order of their nodes and stops
+ */
+void st_hold_lines(int hold);
+
 void printSymTab(FILE * listing);
 
 #endif
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""deep.py CMINUS [DEPTH]: compiles a program whose syntax tree is DEPTH
+(default 8000) nodes deep, with a C stack far smaller than a recursive
+walk of it needs, then edits it in an -i session: once before the deep
+function, which moves its lines, and once inside it, which parses it
+again and frees its old tree. Every listing must match a cold compile
+of the same text."""
+import os, resource, subprocess, sys, tempfile
+
+cminus = os.path.abspath(sys.argv[1])
+depth = int(sys.argv[2]) if len(sys.argv) > 2 else 8000
+STACK = 192 * 1024
+
+def small_stack():
+    resource.setrlimit(resource.RLIMIT_STACK, (STACK, STACK))
+
+def run(args, text=b''):
+    r = subprocess.run([cminus] + args, input=text, capture_output=True,
+                       preexec_fn=small_stack, timeout=600)
+    if r.returncode != 0:
+        sys.exit('FAIL: cminus %s exited with %d' % (' '.join(args), r.returncode))
+    return r.stdout
+
+# x = x + 1 + 1 ... is a left-leaning chain of depth operators
+source = ('int g(int a)\n{ return a; }\n'
+          'int f(int x)\n{ x = x' + ' + 1' * depth + ';\n  return x; }\n'
+          'void main(void) { output(f(g(1))); }\n').encode()
+# each edit replaces one byte: the first adds a line to g, the
+# second turns the last + of the chain in f into a -
+edits = [(b'{ return', b'{\n'), (b'+ 1;', b'-')]
+
+os.chdir(tempfile.mkdtemp())
+open('deep.cm', 'wb').write(source)
+script = b''
+texts = [source]
+for where, new in edits:
+    text = texts[-1]
+    at = text.index(where)
+    script += b'%d %d %d\n' % (at, at + 1, len(new)) + new
+    texts.append(text[:at] + new + text[at + 1:])
+listings = run(['-i', 'deep.cm'], script).split(b'\nCMINUS COMPILATION: ')[1:]
+if len(listings) != len(texts):
+    sys.exit('FAIL: %d listings for %d sources' % (len(listings), len(texts)))
+for i, text in enumerate(texts):
+    open('deep.cm', 'wb').write(text)
+    cold = run(['deep.cm']).split(b'\nCMINUS COMPILATION: ')[1]
+    if listings[i] != cold:
+        sys.exit('FAIL: listing %d differs from a cold compile' % i)
+    if b'Type Checking Finished' not in cold:
+        sys.exit('FAIL: listing %d is not analyzed' % i)
+print('deep: ok, depth %d, %d edits' % (depth, len(edits)))
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""edits.py CMINUS [SESSIONS [EDITS]]: runs SESSIONS (default 10) -i
+sessions of EDITS (default 20) random edits on each example program:
+spacing and comments between tokens, renamed identifiers and changed
+numbers, new statements and declarations, joined lines, stray braces,
+comment marks and EOF, and undoing the edit before; then one session
+that changes what the bodies of a program use from Global: a callee's
+parameter types, a global's type, a return type, and a duplicate
+function. Every listing must match a cold compile of the same text,
+whether or not the session kept the analysis of a body."""
+import os, random, re, subprocess, sys, tempfile
+
+cminus = os.path.abspath(sys.argv[1])
+sessions = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+nedits = int(sys.argv[3]) if len(sys.argv) > 3 else 20
+here = os.path.dirname(os.path.abspath(__file__))
+examples = ['gcd.cm', 'sort.cm', 'test.cm', 'test2.cm', 'check_if_else.cm']
+KEYWORDS = (b'int', b'void', b'if', b'else', b'while', b'return')
+
+USES = b'''int g;
+int arr[5];
+int f(int a, int b) { return a + b; }
+void h(void)
+{ int x;
+  x = f(g, 2);
+  arr[1] = x;
+}
+int k(int z[])
+{ return z[0] + f(1,2); }
+void main(void)
+{ int q[3];
+  h();
+  g = k(q) + k(arr);
+  output(g);
+}
+'''
+# each replaces the first occurrence of a text with another
+USES_EDITS = [(b'int b)', b'int b[])'), (b'int g;', b'int g[3];'),
+              (b'int g[3];', b'int g;'), (b'int b[])', b'int b)'),
+              (b'arr[1] = x;', b'arr[1] = x;\n\n'), (b'void h', b'int h'),
+              (b'', b'int f(int a, int b) { return a; }\n')]
+
+def edit(R, text, versions):
+    """returns a random edit (from, to, new text) of text, or None"""
+    kind = R.randrange(7)
+    if kind == 0:
+        a = R.choice([m.start() for m in re.finditer(rb'[;{}(),]', text)]) + 1
+        return a, a, R.choice([b'\n', b' ', b'\n\n', b'/* x\n y */', b'/**/'])
+    if kind == 1:
+        m = R.choice(list(re.finditer(rb'[A-Za-z]+|[0-9]+', text)))
+        if m.group() in KEYWORDS: new = m.group()
+        elif m.group()[:1].isdigit(): new = b'%d' % R.randint(0, 99)
+        else: new = R.choice([b'x', b'y', b'foo', b'i', b'input'])
+        return m.start(), m.end(), new
+    if kind == 2:
+        places = [m.end() for m in re.finditer(rb'[;{]\s*\n', text)]
+        if not places: return None
+        a = R.choice(places)
+        return a, a, R.choice([b'  x = x + 1;\n', b'  output(2);\n', b'  { }\n',
+                               b'  if (1 < 2) output(3);\n'])
+    if kind == 3:
+        a = R.choice([0, len(text)])
+        return a, a, R.choice([b'int newg;\n', b'void h(void) { output(1); }\n', b'\n'])
+    if kind == 4:
+        a = R.choice([m.start() for m in re.finditer(rb'\n', text)])
+        return a, a + 1, b' '
+    if kind == 5:
+        a = R.randint(0, len(text))
+        return a, a, R.choice([b'}', b'{', b'/*', b'*/', b'EOF', b'@'])
+    if len(versions) < 2: return None
+    prev = versions[-2]
+    p = 0
+    while p < min(len(prev), len(text)) and prev[p] == text[p]: p += 1
+    q = 0
+    while q < min(len(prev), len(text)) - p and prev[-1-q] == text[-1-q]: q += 1
+    return p, len(text) - q, prev[p:len(prev)-q]
+
+def run(args, text=b''):
+    r = subprocess.run([cminus] + args, input=text, capture_output=True, timeout=300)
+    if r.returncode != 0:
+        sys.exit('FAIL: cminus %s exited with %d' % (' '.join(args), r.returncode))
+    return r.stdout
+
+def session(name, original, edits):
+    """runs the edits on original in an -i session and checks every
+    listing against a cold compile"""
+    versions = [original]
+    script = b''
+    for a, b, new in edits:
+        script += b'%d %d %d\n' % (a, b, len(new)) + new
+        versions.append(versions[-1][:a] + new + versions[-1][b:])
+    open('p.cm', 'wb').write(original)
+    listings = run(['-i', 'p.cm'], script).split(b'\nCMINUS COMPILATION: ')[1:]
+    if len(listings) != len(versions):
+        sys.exit('FAIL: %s: %d listings for %d sources' % (name, len(listings), len(versions)))
+    for i, text in enumerate(versions):
+        open('p.cm', 'wb').write(text)
+        cold = run(['p.cm']).split(b'\nCMINUS COMPILATION: ')[1]
+        if listings[i] != cold:
+            open('bad.cm', 'wb').write(text)
+            sys.exit('FAIL: %s: listing %d differs from a cold compile (see %s)'
+                     % (name, i, os.path.abspath('bad.cm')))
+    return len(edits)
+
+os.chdir(tempfile.mkdtemp())
+count = 0
+for example in examples:
+    original = open(os.path.join(here, '..', example), 'rb').read()
+    for seed in range(1, sessions + 1):
+        R = random.Random(seed)
+        versions = [original]
+        edits = []
+        for i in range(nedits):
+            e = edit(R, versions[-1], versions)
+            if e is None: continue
+            a, b, new = e
+            edits.append(e)
+            versions.append(versions[-1][:a] + new + versions[-1][b:])
+        count += session('%s seed %d' % (example, seed), original, edits)
+text = USES
+edits = []
+for old, new in USES_EDITS:
+    a = text.index(old)
+    edits.append((a, a + len(old), new))
+    text = text[:a] + new + text[a + len(old):]
+count += session('uses of Global', USES, edits)
+print('edits: ok, %d edits in %d sessions' % (count, sessions * len(examples) + 1))
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""stress.py CMINUS [NODES]: compiles a generated program of at least
+NODES (default 10000000) syntax tree nodes with a C stack far smaller
+than a recursive walk of it needs: long functions of x = x + 1;
+statements, a block nesting 500 deep and an expression 10000 deep.
+(The listing indents each node by its depth, so much deeper trees take
+quadratic time to print, and the recursive-descent parser recurses on
+nested blocks.) The listing must print every node of the tree and
+finish type checking."""
+import os, resource, subprocess, sys, tempfile
+
+cminus = os.path.abspath(sys.argv[1])
+nodes = int(sys.argv[2]) if len(sys.argv) > 2 else 10000000
+STACK = 192 * 1024
+PER_FUNCTION = 10000 # statements
+
+def small_stack():
+    resource.setrlimit(resource.RLIMIT_STACK, (STACK, STACK))
+
+def name(i):
+    s = ''
+    while True:
+        s = chr(97 + i % 26) + s; i //= 26
+        if i == 0: return 'f' + s
+
+# x = x + 1 + 1 ... is a left-leaning chain, 2 nodes per term; each
+# nested if is 3 nodes and each statement 5; each function adds 4
+depth = min(10000, nodes // 10)
+nesting = min(500, nodes // 100)
+left = nodes - 2 * depth - 3 * nesting
+w = open(os.path.join(tempfile.mkdtemp(), 'stress.cm'), 'w')
+w.write('int deep(int x)\n{ x = x' + ' + 1' * depth + ';\n')
+w.write('  if (x) {\n' * nesting + '  x = 0;\n' + '  }\n' * nesting)
+w.write('  return x; }\n')
+f = 0
+while left > 0:
+    n = min(PER_FUNCTION, left // 5 + 1)
+    w.write('void %s(void)\n{ int x;\n  x = 0;\n' % name(f))
+    w.write('  x = x + 1;\n' * n)
+    w.write('}\n')
+    left -= 5 * n + 4
+    f += 1
+w.write('void main(void) { output(deep(1)); }\n')
+w.close()
+
+p = subprocess.Popen([cminus, w.name], stdout=subprocess.PIPE,
+                     preexec_fn=small_stack)
+printed = 0
+in_tree = finished = False
+for line in p.stdout:
+    if line == b'Syntax tree:\n': in_tree = True
+    elif line == b'Building Symbol Table...\n': in_tree = False
+    elif in_tree and line.strip(): printed += 1
+    elif line == b'Type Checking Finished\n': finished = True
+if p.wait() != 0:
+    sys.exit('FAIL: cminus exited with %d' % p.returncode)
+os.remove(w.name)
+os.rmdir(os.path.dirname(w.name))
+if printed < nodes:
+    sys.exit('FAIL: %d nodes printed, %d expected' % (printed, nodes))
+if not finished:
+    sys.exit('FAIL: type checking did not finish')
+print('stress: ok, %d nodes, %d functions' % (printed, f + 1))
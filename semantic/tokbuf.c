@@ -0,0 +1,65 @@
+/****************************************************/
+/* File: tokbuf.c                                   */
+/* Token buffer for the C- compiler                 */
+/****************************************************/
+
+#include "globals.h"
+#include "intern.h"
+#include "tokbuf.h"
+
+/* initial capacity of a token buffer */
+#define INITTOKENS 4096
+
+/* growArray resizes *a to n elements of size bytes */
+static void growArray(void * a, int n, size_t size)
+{ void * p = realloc(*(void **) a,n*size);
+  if (p==NULL)
+  { fprintf(listing,"Out of memory error\n");
+    exit(1);
+  }
+  *(void **) a = p;
+}
+
+void reserveTokens(TokenBuffer * tb, int n)
+{ if (n <= tb->capacity) return;
+  tb->capacity = n;
+  growArray(&tb->kind,n,sizeof(short));
+  growArray(&tb->start,n,sizeof(long));
+  growArray(&tb->len,n,sizeof(int));
+  growArray(&tb->line,n,sizeof(int));
+}
+
+void appendToken(TokenBuffer * tb, TokenType kind, long start, int len, int line)
+{ int i = tb->ntokens;
+  if (i == tb->capacity)
+    reserveTokens(tb,tb->capacity ? tb->capacity*2 : INITTOKENS);
+  tb->kind[i] = kind;
+  tb->start[i] = start;
+  tb->len[i] = len;
+  tb->line[i] = line;
+  tb->ntokens++;
+}
+
+char * tokenText(Compilation * c, int i)
+{ TokenBuffer * tb = c->tokens;
+  int n = tb->len[i];
+  if (tb->kind[i] == ID) return intern(c->sourceText+tb->start[i],n);
+  if (n+1 > c->textCopySize)
+  { c->textCopySize = n+1 > 2*c->textCopySize ? n+1 : 2*c->textCopySize;
+    growArray(&c->textCopy,c->textCopySize,1);
+  }
+  memcpy(c->textCopy,c->sourceText+tb->start[i],n);
+  c->textCopy[n] = '\0';
+  return c->textCopy;
+}
+
+TokenType nextToken(Compilation * c)
+{ TokenBuffer * tb = c->tokens;
+  int i = tb->cursor;
+  if (i < tb->stop) tb->cursor++;
+  c->lineno = tb->line[i];
+  c->tokenOffset = tb->start[i];
+  c->tokenLength = tb->len[i];
+  c->tokenString = tokenText(c,i);
+  return i < tb->stop ? tb->kind[i] : ENDFILE;
+}
@@ -0,0 +1,52 @@
+/****************************************************/
+/* File: tokbuf.h                                   */
+/* Token buffer for the C- compiler: the whole      */
+/* source is scanned up front into parallel arrays  */
+/* that the parser then reads through a cursor      */
+/****************************************************/
+
+#ifndef _TOKBUF_H_
+#define _TOKBUF_H_
+
+/* token i has kind kind[i] and is the len[i] chars
+ * at sourceText[start[i]] on line line[i]; the last
+ * token in the buffer is always ENDFILE
+ */
+typedef struct TokenBufferRec
+   { int ntokens;
+     int capacity;
+     short * kind;
+     long * start;
+     int * len;
+     int * line;
+     int cursor; /* index of the next token for nextToken */
+     int stop;   /* nextToken gives ENDFILE from here on */
+   } TokenBuffer;
+
+/* Procedure scanTokens scans the whole source of c
+ * into its token buffer c->tokens, which it creates
+ * if need be (it is part of the scanner, in cminus.l)
+ */
+void scanTokens(Compilation * c);
+
+/* Procedure reserveTokens makes room for n tokens */
+void reserveTokens(TokenBuffer * tb, int n);
+
+/* Procedure appendToken adds a token to the buffer */
+void appendToken(TokenBuffer * tb, TokenType kind, long start, int len, int line);
+
+/* Function tokenText returns the lexeme of token i
+ * of the token buffer of c: the interned name for
+ * an ID, otherwise a copy valid until the next call
+ */
+char * tokenText(Compilation * c, int i);
+
+/* Function nextToken returns the token under the
+ * cursor of the token buffer of c and advances it,
+ * setting lineno, tokenString, tokenOffset and
+ * tokenLength as getToken does; once the cursor is
+ * at stop it keeps returning ENDFILE
+ */
+TokenType nextToken(Compilation * c);
+
+#endif
@@ -8,12 +8,14 @@
 
 #include "globals.h"
 #include "util.h"
+#include "arena.h"
+#include "compact.h"
 
 char *typeStrings[] = {"void", "int", "int[]"};
-/* Procedure printToken prints a token 
- * and its lexeme to the listing file
+/* Procedure fprintToken prints a token 
+ * and its lexeme to the file f
  */
-void printToken( TokenType token, const char* tokenString )
+void fprintToken( FILE * f, TokenType token, const char* tokenString )
 { switch (token)
   { case IF:
     case ELSE:
@@ -21,51 +23,90 @@ void printToken( TokenType token, const char* tokenString )
     case RETURN:
     case INT:
     case VOID:
-      fprintf(listing,
+      fprintf(f,
          "reserved word: %s\n",tokenString);
       break;
-    case ASSIGN: fprintf(listing,"=\n"); break;
-    case EQ: fprintf(listing,"==\n"); break;
-    case NE: fprintf(listing,"!=\n"); break;    
-    case LT: fprintf(listing,"<\n"); break;
-    case LE: fprintf(listing,"<=\n"); break;
-    case GT: fprintf(listing,">\n"); break;
-    case GE: fprintf(listing,">=\n"); break;        
-    case LPAREN: fprintf(listing,"(\n"); break;
-    case RPAREN: fprintf(listing,")\n"); break;
-    case LBRACE: fprintf(listing,"[\n"); break;
-    case RBRACE: fprintf(listing,"]\n"); break;
-    case LCURLY: fprintf(listing,"{\n"); break;
-    case RCURLY: fprintf(listing,"}\n"); break;
-    case SEMI: fprintf(listing,";\n"); break;
-    case COMMA: fprintf(listing,",\n"); break;
-    case PLUS: fprintf(listing,"+\n"); break;
-    case MINUS: fprintf(listing,"-\n"); break;
-    case TIMES: fprintf(listing,"*\n"); break;
-    case OVER: fprintf(listing,"/\n"); break;
-    case ENDFILE: fprintf(listing,"EOF\n"); break;
+    case ASSIGN: fprintf(f,"=\n"); break;
+    case EQ: fprintf(f,"==\n"); break;
+    case NE: fprintf(f,"!=\n"); break;    
+    case LT: fprintf(f,"<\n"); break;
+    case LE: fprintf(f,"<=\n"); break;
+    case GT: fprintf(f,">\n"); break;
+    case GE: fprintf(f,">=\n"); break;        
+    case LPAREN: fprintf(f,"(\n"); break;
+    case RPAREN: fprintf(f,")\n"); break;
+    case LBRACE: fprintf(f,"[\n"); break;
+    case RBRACE: fprintf(f,"]\n"); break;
+    case LCURLY: fprintf(f,"{\n"); break;
+    case RCURLY: fprintf(f,"}\n"); break;
+    case SEMI: fprintf(f,";\n"); break;
+    case COMMA: fprintf(f,",\n"); break;
+    case PLUS: fprintf(f,"+\n"); break;
+    case MINUS: fprintf(f,"-\n"); break;
+    case TIMES: fprintf(f,"*\n"); break;
+    case OVER: fprintf(f,"/\n"); break;
+    case ENDFILE: fprintf(f,"EOF\n"); break;
     case NUM:
-      fprintf(listing,
+      fprintf(f,
           "NUM, val= %s\n",tokenString);
       break;
     case ID:
-      fprintf(listing,
+      fprintf(f,
           "ID, name= %s\n",tokenString);
       break;
     case ERROR:
-      fprintf(listing,
+      fprintf(f,
           "ERROR: %s\n",tokenString);
       break;
     default: /* should never happen */
-      fprintf(listing,"Unknown token: %d\n",token);
+      fprintf(f,"Unknown token: %d\n",token);
+  }
+}
+
+/* Procedure printToken prints a token 
+ * and its lexeme to the listing file
+ */
+void printToken( TokenType token, const char* tokenString )
+{ fprintToken(listing,token,tokenString);
+}
+
+/* allocNode takes a node given back to arena a by
+ * freeTree, or else a new one from it
+ */
+static TreeNode * allocNode(Arena * a)
+{ TreeNode * t = (TreeNode *) a->spareNodes;
+  if (t == NULL) return (TreeNode *) arenaAlloc(a,sizeof(TreeNode));
+  a->spareNodes = t->sibling;
+  return t;
+}
+
+/* freeTree keeps the nodes still to be freed in one
+ * list through their sibling fields: the lists of
+ * children of a node are spliced in ahead of the
+ * rest, so no stack is needed however deep t is
+ */
+void freeTree(Arena * a, TreeNode * t)
+{ while (t != NULL)
+  { TreeNode * next = t->sibling;
+    int i;
+    for (i=0;i<MAXCHILDREN;i++)
+      if (t->child[i] != NULL)
+      { TreeNode * last = t->child[i];
+        while (last->sibling != NULL) last = last->sibling;
+        last->sibling = next;
+        next = t->child[i];
+      }
+    t->sibling = (TreeNode *) a->spareNodes;
+    a->spareNodes = t;
+    t = next;
   }
 }
 
 /* Function newStmtNode creates a new statement
- * node for syntax tree construction
+ * node on line lineno for syntax tree construction
  */
-TreeNode * newStmtNode(StmtKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newStmtNode(Arena * a, StmtKind kind, int lineno)
+{ TreeNode * t = allocNode(a);
   int i;
   if (t==NULL)
     fprintf(listing,"Out of memory error at line %d\n",lineno);
@@ -73,14 +114,16 @@ TreeNode * newStmtNode(StmtKind kind)
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = StmtK;
+    t->attr.name = NULL;
+    t->size = 0;
     t->kind.stmt = kind;
     t->lineno = lineno;
   }
   return t;
 }
 
-TreeNode * newDecNode(DecKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newDecNode(Arena * a, DecKind kind, int lineno)
+{ TreeNode * t = allocNode(a);
   int i;
   if (t==NULL)
     fprintf(listing,"Out of memory error at line %d\n",lineno);
@@ -88,6 +131,8 @@ TreeNode * newDecNode(DecKind kind)
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = DecK;
+    t->attr.name = NULL;
+    t->size = 0;
     t->kind.dec = kind;
     t->lineno = lineno;
   }
@@ -95,10 +140,10 @@ TreeNode * newDecNode(DecKind kind)
 }
 
 /* Function newExpNode creates a new expression 
- * node for syntax tree construction
+ * node on line lineno for syntax tree construction
  */
-TreeNode * newExpNode(ExpKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newExpNode(Arena * a, ExpKind kind, int lineno)
+{ TreeNode * t = allocNode(a);
   int i;
   if (t==NULL)
     fprintf(listing,"Out of memory error at line %d\n",lineno);
@@ -106,6 +151,8 @@ TreeNode * newExpNode(ExpKind kind)
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = ExpK;
+    t->attr.name = NULL;
+    t->size = 0;
     t->kind.exp = kind;
     t->lineno = lineno;
     t->type = Void;
@@ -116,123 +163,136 @@ TreeNode * newExpNode(ExpKind kind)
 /* Function copyString allocates and makes a new
  * copy of an existing string
  */
-char * copyString(char * s)
+char * copyString(Arena * a, char * s)
 { int n;
   char * t;
   if (s==NULL) return NULL;
   n = strlen(s)+1;
-  t = malloc(n);
+  t = arenaAlloc(a,n);
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(listing,"Out of memory error\n");
   else strcpy(t,s);
   return t;
 }
 
-/* Variable indentno is used by printTree to
- * store current number of spaces to indent
- */
-static indentno = 0;
-
-/* macros to increase/decrease indentation */
-#define INDENT indentno+=2
-#define UNINDENT indentno-=2
-
-/* printSpaces indents by printing spaces */
-static void printSpaces(void)
+/* printSpaces indents by printing n spaces */
+static void printSpaces(int n)
 { int i;
-  for (i=0;i<indentno;i++)
+  for (i=0;i<n;i++)
     fprintf(listing," ");
 }
 
-/* procedure printTree prints a syntax tree to the 
- * listing file using indentation to indicate subtrees
+/* what printTree passes printNode: the tree, and
+ * the depth of the walk, the number of nodes
+ * entered and not yet left
  */
-void printTree( TreeNode * tree )
-{ int i;
-  INDENT;
-  while (tree != NULL) {
-    printSpaces();
-    if (tree->nodekind==StmtK)
-    { switch (tree->kind.stmt) {
-        case IfK:
-          if(tree->child[2] == NULL)
-            fprintf(listing,"If (condition) (body)\n");
-          else
-            fprintf(listing,"If (condition) (body) (else)\n");
-          break;
-        case WhileK:
-          fprintf(listing,"While\n");
-          break;
-        case CompK:
-          fprintf(listing,"Compound statement :\n");
-          break;
-        case RetK:
-          fprintf(listing,"Return\n");
-          break;
-        default:
-          fprintf(listing,"Unknown StmtNode kind\n");
-          break;
-      }
+typedef struct
+   { CompactTree * tree;
+     int depth;
+   } Printer;
+
+/* printNode prints node t, indented one step more
+ * than its parent, and enters it
+ */
+static void printNode( NodeId t, void * arg )
+{ Printer * p = (Printer *) arg;
+  CompactTree * tree = p->tree;
+  printSpaces(2*++p->depth);
+  if (tree->nodekind[t]==StmtK)
+  { switch (tree->kind[t]) {
+      case IfK:
+        if(tree->child[t][2] == 0)
+          fprintf(listing,"If (condition) (body)\n");
+        else
+          fprintf(listing,"If (condition) (body) (else)\n");
+        break;
+      case WhileK:
+        fprintf(listing,"While\n");
+        break;
+      case CompK:
+        fprintf(listing,"Compound statement :\n");
+        break;
+      case RetK:
+        fprintf(listing,"Return\n");
+        break;
+      default:
+        fprintf(listing,"Unknown StmtNode kind\n");
+        break;
     }
-    else if (tree->nodekind==ExpK)
-    { switch (tree->kind.exp) {
-        case OpK:
-          if(tree->attr.op == ASSIGN){
-            fprintf(listing,"Assign :(destination) (source)\n");
-          }
-          else{
-            fprintf(listing,"Op: ");
-            printToken(tree->attr.op,"");
-          }
-          break;
-        case ConstK:
-          fprintf(listing,"Const: %d\n",tree->attr.val);
-          break;
-        case IdK:
-          fprintf(listing,"Id: %s\n",tree->attr.name);
-          break;
-        case CallK:
-          fprintf(listing,"Call, name: %s, with arguments below\n",tree->attr.name);
-          break;
-        case ArrIdK:
-          fprintf(listing,"Array : [%s]\n",tree->attr.name);
-          break;
-        default:
-          fprintf(listing,"Unknown ExpNode kind\n");
-          break;
-      }
+  }
+  else if (tree->nodekind[t]==ExpK)
+  { switch (tree->kind[t]) {
+      case OpK:
+        if(tree->attr[t].op == ASSIGN){
+          fprintf(listing,"Assign :(destination) (source)\n");
+        }
+        else{
+          fprintf(listing,"Op: ");
+          printToken(tree->attr[t].op,"");
+        }
+        break;
+      case ConstK:
+        fprintf(listing,"Const: %d\n",tree->attr[t].val);
+        break;
+      case IdK:
+        fprintf(listing,"Id: %s\n",tree->attr[t].name);
+        break;
+      case CallK:
+        fprintf(listing,"Call, name: %s, with arguments below\n",tree->attr[t].name);
+        break;
+      case ArrIdK:
+        fprintf(listing,"Array : [%s]\n",tree->attr[t].name);
+        break;
+      default:
+        fprintf(listing,"Unknown ExpNode kind\n");
+        break;
     }
-    else if (tree->nodekind==DecK)
-    { switch (tree->kind.dec) {
-        case VarK:
-          if( tree-> type == Array)
-            fprintf(listing,"Var declaration, name: %s, type: %s, size: %d\n",tree->attr.name, typeStrings[tree->type], tree->size );
-          else
-            fprintf(listing,"Var declaration, name: %s, type: %s\n",tree->attr.name, typeStrings[tree->type]);
-          break;
-        case FunK:
-          fprintf(listing,"Function declaration, name: %s, return type: %s\n",tree->attr.name, typeStrings[tree->type]);
-          break;
-        case ParamK:
-          /*
-          if(tree->type == 0)
-            fprintf(listing,"Param: %s\n",tree->type);
-          else
-          */
-          if(tree->type == Array)
-            fprintf(listing,"array Param, name: %s, type: %s , size: %d\n",tree->attr.name, typeStrings[tree->type], tree->size);
-          else
-            fprintf(listing,"single Parameter, name: %s, type: %s\n",tree->attr.name, typeStrings[tree->type]);
-          break;
-        default:
-          fprintf(listing,"Unknown DecNode kind\n");
-          break;
-      }
+  }
+  else if (tree->nodekind[t]==DecK)
+  { switch (tree->kind[t]) {
+      case VarK:
+        if( tree->type[t] == Array)
+          fprintf(listing,"Var declaration, name: %s, type: %s, size: %d\n",tree->attr[t].name, typeStrings[tree->type[t]], tree->size[t] );
+        else
+          fprintf(listing,"Var declaration, name: %s, type: %s\n",tree->attr[t].name, typeStrings[tree->type[t]]);
+        break;
+      case FunK:
+        fprintf(listing,"Function declaration, name: %s, return type: %s\n",tree->attr[t].name, typeStrings[tree->type[t]]);
+        break;
+      case ParamK:
+        /*
+        if(tree->type[t] == 0)
+          fprintf(listing,"Param: %s\n",tree->type[t]);
+        else
+        */
+        if(tree->type[t] == Array)
+          fprintf(listing,"array Param, name: %s, type: %s , size: %d\n",tree->attr[t].name, typeStrings[tree->type[t]], tree->size[t]);
+        else
+          fprintf(listing,"single Parameter, name: %s, type: %s\n",tree->attr[t].name, typeStrings[tree->type[t]]);
+        break;
+      default:
+        fprintf(listing,"Unknown DecNode kind\n");
+        break;
     }
-    else fprintf(listing,"Unknown node kind\n");
-    for (i=0;i<MAXCHILDREN;i++)
-         printTree(tree->child[i]);
-    tree = tree->sibling;
   }
-  UNINDENT;
+  else fprintf(listing,"Unknown node kind\n");
+}
+
+/* leaveNode leaves node t once its subtrees are
+ * printed
+ */
+static void leaveNode( NodeId t, void * arg )
+{ (void) t;
+  ((Printer *) arg)->depth--;
+}
+
+/* procedure printTree prints a syntax tree to the 
+ * listing file using indentation to indicate subtrees
+ */
+void printTree( CompactTree * tree )
+{ Printer p;
+  if (tree->root == 0) return;
+  p.tree = tree;
+  p.depth = 0;
+  walkTree(tree,tree->root,printNode,leaveNode,&p);
 }
@@ -13,25 +13,37 @@
  */
 void printToken( TokenType, const char* );
 
+/* Procedure fprintToken prints a token 
+ * and its lexeme to the given file
+ */
+void fprintToken( FILE *, TokenType, const char* );
+
 /* Function newStmtNode creates a new statement
- * node for syntax tree construction
+ * node on the given line for syntax tree
+ * construction, in the given arena
  */
-TreeNode * newStmtNode(StmtKind);
-TreeNode * newDecNode(DecKind kind);
+TreeNode * newStmtNode(Arena *, StmtKind, int);
+TreeNode * newDecNode(Arena * a, DecKind kind, int lineno);
 
 /* Function newExpNode creates a new expression 
- * node for syntax tree construction
+ * node on the given line for syntax tree
+ * construction, in the given arena
+ */
+TreeNode * newExpNode(Arena *, ExpKind, int);
+
+/* Procedure freeTree gives the nodes of the subtree
+ * t back to arena a, for new nodes to reuse
  */
-TreeNode * newExpNode(ExpKind);
+void freeTree(Arena * a, TreeNode * t);
 
 /* Function copyString allocates and makes a new
- * copy of an existing string
+ * copy of an existing string in the given arena
  */
-char * copyString( char * );
+char * copyString( Arena *, char * );
 
 /* procedure printTree prints a syntax tree to the 
  * listing file using indentation to indicate subtrees
  */
-void printTree( TreeNode * );
+void printTree( CompactTree * );
 
 #endif